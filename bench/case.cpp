@@ -0,0 +1,29 @@
+///	@file
+///	@brief		pug++  - Benchmark of case/when by count of labels
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	A case inside a 10-iteration each matches the last label.
+///	Build it at the parent of the change as well to compare.
+
+#include "../pug.hpp"
+#include <chrono>
+#include <cstdio>
+
+int main() {
+	std::printf("  labels    us per case\n");
+	for (int const labels: {4, 16, 64, 256}) {
+		std::string pug{"each i in [1, 2, 3, 4, 5, 6, 7, 8, 9, 10]\n\tcase v\n"};
+		for (int i = 0; i < labels; ++i) pug += "\t\twhen \"l" + std::to_string(i) + "\"\n\t\t\tp " + std::to_string(i) + "\n";
+		pug += "\t\tdefault\n\t\t\tp none\n";
+		xxx::pug::template_t const	compiled{pug};
+		xxx::pug::variables_t const variables{{"v", "l" + std::to_string(labels - 1)}};
+		(void)compiled.render(variables);	 // Warms up.
+
+		int const  renders = 100;
+		auto const begin   = std::chrono::steady_clock::now();
+		for (int r = 0; r < renders; ++r) (void)compiled.render(variables);
+		auto const us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+		std::printf("  %6d    %8.1f\n", labels, us / (renders * 10));
+	}
+}
@@ -0,0 +1,57 @@
+///	@file
+///	@brief		pug++  - Benchmark of deep documents
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	A chain of nested elements is built, rendered in compact mode and released.
+///	Building it by nodes avoids the source, where depth N needs N*(N-1)/2 tabs.
+///	Build it at the parent of the change as well to compare; it overflowed the stack there beyond a few thousands.
+
+#include "../pug.hpp"
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+///	@brief	Gets milliseconds between the time points.
+///	@param[in]	begin	The beginning.
+///	@param[in]	end		The end.
+///	@return		Milliseconds.
+inline double ms(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) {
+	return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+///	@brief	Builds, renders and releases the chain of the @p depth.
+///	@param[in]	depth	Depth of the chain.
+///	@param[in]	source	Whether the chain is parsed from the source or built by nodes.
+void run(std::size_t depth, bool source) {
+	namespace impl = xxx::pug::impl;
+	auto const					 begin = std::chrono::steady_clock::now();
+	std::string					 pug;
+	std::shared_ptr<impl::line_node_t> root;
+	if (source) {
+		for (std::size_t i = 0u; i < depth; ++i) pug += std::string(i, '\t') + "b\n";
+		root = impl::parse_file(pug);
+	} else {
+		root = std::make_shared<impl::line_node_t>(impl::line_t{0u, std::string_view{}}, nullptr);
+		for (auto node = root; auto i: std::views::iota(std::size_t{}, depth)) node = node->push_nest({i, "b"}, node);
+	}
+	(void)impl::compile_fragments(*root, impl::last_fragment);
+	auto const built = std::chrono::steady_clock::now();
+
+	xxx::pug::options_t options;
+	options.compact		  = true;
+	auto const [out, ctx] = impl::parse_line(impl::context_t{{}, options}, root, "./");
+	auto const rendered	  = std::chrono::steady_clock::now();
+	root.reset();
+	auto const released = std::chrono::steady_clock::now();
+	std::printf("  %7zu%s  %9.1f  %9.1f  %9.1f  %9zu\n", depth, source ? " (source)" : "         ", ms(begin, built), ms(built, rendered), ms(rendered, released), out.size());
+}
+
+}	 // namespace
+
+int main() {
+	std::printf("    depth              build ms  render ms  release ms     bytes\n");
+	for (std::size_t const depth: {1000u, 10000u, 100000u}) run(depth, false);
+	run(5000u, true);
+}
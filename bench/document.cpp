@@ -0,0 +1,49 @@
+///	@file
+///	@brief		pug++  - Benchmark of editing a document
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	A document of about 5000 lines nested under html/body is parsed in full,
+///	and lines in its middle are changed, inserted and deleted, and outdented.
+
+#include "../pug.hpp"
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+///	@brief	Measures the @p f repeatedly.
+///	@param[in]	f		Function taking the index of the repetition.
+///	@param[in]	count	Count of the repetitions.
+///	@return		Microseconds per call.
+template<typename F>
+double measure(F const& f, int count) {
+	auto const begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i) f(i);
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / count;
+}
+
+}	 // namespace
+
+int main() {
+	std::string pug{"doctype html\nhtml\n\thead\n\t\ttitle t\n\tbody\n"};
+	for (int i = 0; std::ranges::count(pug, '\n') < 5000; ++i) {
+		pug += "\t\tsection#s" + std::to_string(i) + "\n\t\t\th2 Title #{i}\n\t\t\tif x == " + std::to_string(i) + "\n\t\t\t\tp yes\n\t\t\telse\n\t\t\t\tp no\n"
+			   "\t\t\tul\n\t\t\t\tli a\n\t\t\t\tli b\n\t\t\tp end\n";
+	}
+	xxx::pug::document_t document{pug};
+	auto const			 middle = document.lines() / 2u + 3u;	 // A 'h2' line.
+
+	auto const full	   = measure([&pug](int) { (void)xxx::pug::impl::parse_file(pug); }, 20);
+	auto const change  = measure([&document, middle](int i) { document.edit(middle, 1u, i % 2 ? "\t\t\th2 Changed" : "\t\t\th2 Title"); }, 2000);
+	auto const insert  = measure([&document, middle](int i) {
+		 if (i % 2) {
+			 document.edit(middle + 1u, 1u, "");
+		 } else {
+			 document.edit(middle + 1u, 0u, "\t\t\tp inserted\n");
+		 }
+	 }, 2000);
+	auto const outdent = measure([&document, middle](int i) { document.edit(middle, 1u, i % 2 ? "\t\t\th2 Title" : "\t\th2 Title"); }, 200);
+	std::printf("lines %zu\n  full parse_file()      %8.1f us\n  change a line          %8.1f us\n  insert/delete a line   %8.1f us\n  outdent a line         %8.1f us\n",
+				document.lines(), full, change, insert, outdent);
+}
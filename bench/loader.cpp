@@ -0,0 +1,50 @@
+///	@file
+///	@brief		pug++  - Benchmark of loaders of included files
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	A page extending a layout is rendered with files read from the disk, and with memory_loader_t.
+///	Read system calls are counted by /proc/self/io on Linux.
+
+#include "../pug.hpp"
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+///	@brief	Gets the count of read system calls of this process.
+///	@return		The count. It returns -1 if it is unknown.
+long get_read_syscalls() {
+	std::ifstream ifs{"/proc/self/io"};
+	std::string	  key;
+	for (long value{}; ifs >> key >> value;) {
+		if (key == "syscr:") return value;
+	}
+	return -1;
+}
+
+}	 // namespace
+
+int main() {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-bench-loader";
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "layout.pug"} << "doctype html\nhtml\n\thead\n\t\ttitle #{title}\n\tbody\n\t\tblock content\n";
+	std::ofstream{dir / "page.pug"} << "block content\n\th1 Hello, #{name}\n\tul\n\t\teach i in [1, 2, 3]\n\t\t\tli #{i}\n\tp\n\t\t| folded\n\t\t| text\nextends layout.pug\n";
+
+	xxx::pug::memory_loader_t loader;
+	for (auto const* name: {"layout.pug", "page.pug"}) loader.add(dir / name, xxx::pug::impl::load_file(dir / name));
+	auto const					compiled = xxx::pug::compile_file(dir / "page.pug");
+	xxx::pug::variables_t const variables{{"title", "T"}, {"name", "N"}};
+
+	int const renders = 5000;
+	for (bool const memory: {false, true}) {
+		xxx::pug::options_t options;
+		if (memory) options.loader = &loader;
+		auto const reads = get_read_syscalls();
+		auto const begin = std::chrono::steady_clock::now();
+		for (int r = 0; r < renders; ++r) (void)compiled.render(variables, options);
+		auto const us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+		std::printf("%-7s %6.1f us/render, %.2f read syscalls/render\n", memory ? "memory" : "disk", us / renders, static_cast<double>(get_read_syscalls() - reads) / renders);
+	}
+	std::filesystem::remove_all(dir);
+}
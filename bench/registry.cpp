@@ -0,0 +1,118 @@
+///	@file
+///	@brief		pug++  - Benchmark of lookups in the registry
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	Threads look up 32 templates through readers, through a map guarded by std::shared_mutex, and through registry_t::find().
+///	Then templates are reloaded while threads render them, and any failed rendering is counted.
+///	Thread counts are given by the arguments; the default is from 1 to the hardware concurrency.
+///	Scaling is meaningful only on a machine with that many cores.
+
+#include "../pug_registry.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <shared_mutex>
+#include <thread>
+
+namespace {
+
+///	@brief	Map of compiled templates guarded by a shared mutex, to compare.
+struct locked_t {
+	std::shared_mutex																   mutex;
+	std::unordered_map<std::string, std::shared_ptr<xxx::pug::template_t const>> map;
+
+	std::shared_ptr<xxx::pug::template_t const> find(std::string const& name) {
+		std::shared_lock lock{mutex};
+		return map.at(name);
+	}
+};
+
+///	@brief	Runs the @p body by the @p threads.
+///	@param[in]	threads		Count of the threads.
+///	@param[in]	lookups		Count of the lookups per thread.
+///	@param[in]	body		Body of each thread, which takes the index of the thread.
+///	@return		Millions of lookups per second.
+template<typename F>
+double run(unsigned threads, std::size_t lookups, F const& body) {
+	auto const begin = std::chrono::steady_clock::now();
+	{
+		std::vector<std::jthread> workers;
+		for (unsigned t = 0u; t < threads; ++t) workers.emplace_back([&body, t] { body(t); });
+	}
+	return static_cast<double>(lookups * threads) / std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+}
+
+}	 // namespace
+
+int main(int argc, char** argv) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-bench-registry";
+	std::filesystem::create_directories(dir);
+	std::vector<std::string> names;
+	for (int i = 0; i < 32; ++i) {
+		names.push_back("t" + std::to_string(i) + ".pug");
+		std::ofstream{dir / names.back()} << "div\n\th1 Template " << i << "\n\tp #{v}\n";
+	}
+
+	xxx::pug::registry::registry_t registry{dir};
+	locked_t					   locked;
+	for (auto const& name: names) {
+		(void)registry.find(name);
+		locked.map[name] = std::make_shared<xxx::pug::template_t const>(xxx::pug::compile_file(dir / name));
+	}
+
+	std::vector<unsigned> threads;
+	for (int i = 1; i < argc; ++i) threads.push_back(static_cast<unsigned>(std::strtoul(argv[i], nullptr, 10)));
+	if (threads.empty()) {
+		for (unsigned n = 1u; n <= std::max(1u, std::thread::hardware_concurrency()); n *= 2u) threads.push_back(n);
+	}
+	std::size_t const lookups = 200000u;
+	std::printf("hardware concurrency %u\n  threads   reader M/s   shared_mutex M/s   registry.find M/s\n", std::thread::hardware_concurrency());
+	for (auto const n: threads) {
+		std::atomic<std::size_t> sink{};
+		auto const				 reader = run(n, lookups, [&](unsigned t) {
+			xxx::pug::registry::registry_t::reader_t r{registry};
+			std::size_t								 s = 0u;
+			for (std::size_t i = 0u; i < lookups; ++i) s += r.get(names[(i + t) % names.size()]).source().size();
+			sink += s;
+		});
+		auto const				 shared = run(n, lookups, [&](unsigned t) {
+			std::size_t s = 0u;
+			for (std::size_t i = 0u; i < lookups; ++i) s += locked.find(names[(i + t) % names.size()])->source().size();
+			sink += s;
+		});
+		auto const				 find	= run(n, lookups, [&](unsigned t) {
+			std::size_t s = 0u;
+			for (std::size_t i = 0u; i < lookups; ++i) s += registry.find(names[(i + t) % names.size()])->source().size();
+			sink += s;
+		});
+		std::printf("  %7u   %10.1f   %16.1f   %17.1f\n", n, reader, shared, find);
+	}
+
+	std::atomic<bool>		 stop{};
+	std::atomic<std::size_t> renders{}, failures{};
+	{
+		std::vector<std::jthread> workers;
+		for (int t = 0; t < 4; ++t) {
+			workers.emplace_back([&] {
+				xxx::pug::registry::registry_t::reader_t r{registry};
+				while (! stop) {
+					try {
+						(void)r.render(names.front(), {{"v", "x"}});
+						++renders;
+					} catch (std::exception const&) {
+						++failures;
+					}
+				}
+			});
+		}
+		for (int i = 0; i < 50; ++i) {
+			std::ofstream{dir / names.front()} << "p item " << i << "\n";
+			std::filesystem::last_write_time(dir / names.front(), std::filesystem::file_time_type::clock::now() + std::chrono::seconds{i + 1});
+			(void)registry.reload();
+		}
+		stop = true;
+	}
+	std::printf("50 reloads during %zu renders, %zu failed\n", renders.load(), failures.load());
+	std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,105 @@
+///	@file
+///	@brief		pug++  - Benchmark of memory resources
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	It counts allocations from the default memory resource per render and per compile of a page extending a layout,
+///	and it measures renders shared by threads with the default resource and with a monotonic resource per thread.
+///	Allocations of the strings of outputs are global ones, which are not affected by the resources, so they are not counted.
+///	Thread counts are given by the arguments; the default is from 1 to the hardware concurrency.
+///	Scaling is meaningful only on a machine with that many cores.
+
+#include "../pug.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+///	@brief	Memory resource counting the allocations, which replaces the default resource.
+class allocation_counter_t : public std::pmr::memory_resource {
+public:
+	///	@brief	Gets the count of the allocations.
+	///	@return		The count of the allocations since the last reset.
+	std::size_t allocations() const noexcept { return allocations_.load(std::memory_order_relaxed); }
+	///	@brief	Resets the count of the allocations.
+	void reset() noexcept { allocations_.store(0u, std::memory_order_relaxed); }
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+		allocations_.fetch_add(1u, std::memory_order_relaxed);
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override { std::pmr::new_delete_resource()->deallocate(p, bytes, alignment); }
+	bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+	std::atomic<std::size_t> allocations_{};	///< @brief	Count of the allocations.
+};
+
+///	@brief	Writes the page and its layout into the @p dir.
+///	@param[in]	dir		Directory of the files.
+void write_files(std::filesystem::path const& dir) {
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "layout.pug"} << "doctype html\nhtml\n\thead\n\t\ttitle Hello #{x}\n\tbody\n\t\tblock content\n";
+	std::ofstream{dir / "page.pug"} << "block content\n\tp hi 1\n\t\tspan: b there\n\tp\n\t\t| folded\n\t\t| text\n\tdiv.\n\t\traw one\n\t\traw two\n"
+									   "\teach i in [1, 2, 3]\n\t\tli= #{i} <x>\n\t- for (var k = 0; k < 3; k += 1)\n\t\tli #{k}\n\t- var a = 1\n"
+									   "\tif a == 1\n\t\tp one\n\telse\n\t\tp other\n\t//- comment\nextends layout.pug\n";
+}
+
+}	 // namespace
+
+int main(int argc, char** argv) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-bench-resource";
+	write_files(dir);
+	static allocation_counter_t counter;	 // It outlives nodes allocated from it.
+	std::pmr::set_default_resource(&counter);
+	auto const					compiled = xxx::pug::compile_file(dir / "page.pug");
+	xxx::pug::variables_t const variables{{"x", "1"}};
+
+	std::vector<std::byte> buffer(1u << 20u);
+	for (bool const monotonic: {false, true}) {
+		std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size()};	// Its upstream is the counter.
+		xxx::pug::options_t					options;
+		if (monotonic) options.resource = &arena;
+		counter.reset();
+		(void)compiled.render(variables, options);
+		auto const rendering = counter.allocations();
+		counter.reset();
+		(void)xxx::pug::compile_file(dir / "page.pug", monotonic ? &arena : std::pmr::get_default_resource());
+		std::printf("allocations, %-9s: %zu render / %zu compile\n", monotonic ? "monotonic" : "default", rendering, counter.allocations());
+	}
+	std::pmr::set_default_resource(nullptr);	// Threads below do not share the counter.
+
+	std::vector<unsigned> threads;
+	for (int i = 1; i < argc; ++i) threads.push_back(static_cast<unsigned>(std::strtoul(argv[i], nullptr, 10)));
+	if (threads.empty()) {
+		for (unsigned n = 1u; n <= std::max(1u, std::thread::hardware_concurrency()); n *= 2u) threads.push_back(n);
+	}
+	std::printf("hardware concurrency %u\n  threads   default us   monotonic us (256 KiB per thread)\n", std::thread::hardware_concurrency());
+	for (auto const n: threads) {
+		std::printf("  %7u", n);
+		for (bool const monotonic: {false, true}) {
+			std::size_t const renders = 4000u;
+			auto const		  begin	  = std::chrono::steady_clock::now();
+			{
+				std::vector<std::jthread> workers;
+				for (unsigned i = 0u; i < n; ++i) {
+					workers.emplace_back([&compiled, &variables, monotonic, renders, n] {
+						std::vector<std::byte> buffer(256u * 1024u);
+						for (std::size_t r = 0u; r < renders / n; ++r) {
+							std::optional<std::pmr::monotonic_buffer_resource> arena;
+							xxx::pug::options_t								 options;
+							if (monotonic) options.resource = &arena.emplace(buffer.data(), buffer.size());
+							(void)compiled.render(variables, options);
+						}
+					});
+				}
+			}
+			std::printf("   %10.1f", std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / renders);
+		}
+		std::printf("\n");
+	}
+	std::filesystem::remove_all(dir);
+}
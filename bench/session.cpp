@@ -0,0 +1,51 @@
+///	@file
+///	@brief		pug++  - Benchmark of incremental rendering in a session
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	A dashboard of 200 widgets updates 5 variables per tick.
+///	Each tick is rendered in full and updated in a session, and their HTML is compared.
+
+#include "../pug.hpp"
+#include <chrono>
+#include <cstdio>
+
+int main() {
+	std::string				 pug{"doctype html\nhtml\n\thead\n\t\ttitle Dashboard #{title}\n\tbody\n"};
+	xxx::pug::variables_t	 variables{{"title", "live"}};
+	std::vector<std::string> names;
+	for (int i = 0; i < 200; ++i) names.push_back("v" + std::to_string(i));
+	for (int i = 0; i < 200; ++i) {
+		pug += "\t\tdiv.widget(id='w" + std::to_string(i) + "')\n\t\t\th2 Widget " + std::to_string(i) + "\n\t\t\tspan.value #{" + names[i] + "}\n"
+			   "\t\t\tp.description Static description of the widget number " + std::to_string(i) + "\n";
+		variables.emplace(names[i], "0");
+	}
+	xxx::pug::template_t const compiled{pug};
+	xxx::pug::session_t		   session{compiled, variables};
+
+	int const	ticks = 200;
+	double		full_us{}, update_us{};
+	std::size_t full_bytes{}, patch_bytes{}, patches{};
+	for (int tick = 0; tick < ticks; ++tick) {
+		xxx::pug::variables_t updates;
+		for (int k = 0; k < 5; ++k) updates.emplace(names[(tick * 37 + k * 41) % names.size()], std::to_string(tick * 10 + k));
+		for (auto const& [name, value]: updates) variables[name] = value;
+
+		auto const begin   = std::chrono::steady_clock::now();
+		auto const html	   = compiled.render(variables);
+		auto const full	   = std::chrono::steady_clock::now();
+		auto const updated = session.update(updates);
+		auto const end	   = std::chrono::steady_clock::now();
+		full_us += std::chrono::duration<double, std::micro>(full - begin).count();
+		update_us += std::chrono::duration<double, std::micro>(end - full).count();
+		full_bytes += html.size();
+		patches += updated.size();
+		for (auto const& patch: updated) patch_bytes += patch.text.size() + 2u * sizeof(std::size_t);
+		if (session.html() != html) {
+			std::printf("mismatch at tick %d\n", tick);
+			return 1;
+		}
+	}
+	std::printf("full render:    %8.1f us, %zu bytes per tick\n", full_us / ticks, full_bytes / ticks);
+	std::printf("session update: %8.1f us, %.1f patches of %zu bytes per tick (text and offsets)\n", update_us / ticks, static_cast<double>(patches) / ticks, patch_bytes / ticks);
+}
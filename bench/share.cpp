@@ -0,0 +1,63 @@
+///	@file
+///	@brief		pug++  - Benchmark of subtrees shared by templates in a registry
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	A corpus of pages, each of which has the same head, navigation and footer, a unique body and a table,
+///	is compiled into a registry with private nodes and into one with shared nodes.
+///	The count of pages is given by the argument; the default is 2000.
+///	Heap in use is measured by mallinfo2() of glibc.
+
+#include "../pug_registry.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <random>
+
+namespace {
+
+///	@brief	Writes the corpus of the @p count pages into the @p dir.
+///	@param[in]	dir		Directory of the pages.
+///	@param[in]	count	Count of the pages.
+void write_corpus(std::filesystem::path const& dir, int count) {
+	std::filesystem::create_directories(dir);
+	std::string nav{"\tnav.navbar\n\t\tul.menu\n"};
+	for (int i = 0; i < 12; ++i) nav += "\t\t\tli.item\n\t\t\t\ta(href='/section" + std::to_string(i) + "') Section " + std::to_string(i) + "\n";
+	nav += "\t\tif user == 'guest'\n\t\t\ta(href='/login') Log in\n\t\telse\n\t\t\tspan Hello, #{user}\n";
+	std::string footer{"\tfooter\n\t\tdiv.links\n"};
+	for (int i = 0; i < 8; ++i) footer += "\t\t\ta(href='/about" + std::to_string(i) + "') About " + std::to_string(i) + "\n";
+	footer += "\t\tp.copyright (c) 2022-, Example.\n";
+
+	std::mt19937 rng{1u};
+	for (int t = 0; t < count; ++t) {
+		std::string pug{"doctype html\nhtml\n\thead\n\t\ttitle Page " + std::to_string(t) + "\n\t\tmeta(charset='utf-8')\n\tbody\n"};
+		pug += nav;
+		pug += "\tmain\n\t\th1 Page " + std::to_string(t) + "\n";
+		for (int i = 0; i < 10; ++i) pug += "\t\tp Paragraph " + std::to_string(rng() % 1000u) + " of #{user}\n";
+		pug += "\t\ttable\n";
+		for (int i = 0; i < 5; ++i) pug += "\t\t\ttr\n\t\t\t\ttd Cell\n\t\t\t\ttd #{user}\n";
+		pug += footer;
+		std::ofstream{dir / ("t" + std::to_string(t) + ".pug")} << pug;
+	}
+}
+
+}	 // namespace
+
+int main(int argc, char** argv) {
+	int const  count = 1 < argc ? std::atoi(argv[1]) : 2000;
+	auto const dir	 = std::filesystem::temp_directory_path() / "pug-bench-share";
+	write_corpus(dir, count);
+
+	std::printf("  registry     size() MB   shared MB   heap MB   compile s\n");
+	for (bool const share: {false, true}) {
+		auto const before = mallinfo2().uordblks;
+		auto const begin  = std::chrono::steady_clock::now();
+		xxx::pug::registry::registry_t registry{dir, std::numeric_limits<std::size_t>::max(), share};
+		for (int t = 0; t < count; ++t) (void)registry.find("t" + std::to_string(t) + ".pug");
+		auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		auto const heap	   = mallinfo2().uordblks - before;
+		std::printf("  %-8s   %10.1f   %9.1f   %7.1f   %9.2f\n", share ? "shared" : "private", registry.size() / 1e6, registry.shared() / 1e6, heap / 1e6, seconds);
+	}
+	std::filesystem::remove_all(dir);
+}
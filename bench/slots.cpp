@@ -0,0 +1,38 @@
+///	@file
+///	@brief		pug++  - Benchmark of variable lookups by count of host variables
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	A template of 20 interpolated lines with if/else and an each loop is rendered in compact mode
+///	with more and more host variables, most of which the template never refers.
+///	Build it at the parent of the change as well to compare.
+
+#include "../pug.hpp"
+#include <chrono>
+#include <cstdio>
+
+int main() {
+	std::string pug{"div\n"};
+	for (int i = 0; i < 20; ++i) {
+		pug += "\tp Hello #{v" + std::to_string(i) + "} and #{name}\n";
+		pug += "\tif v" + std::to_string(i) + " == 3\n\t\tspan three\n\telse\n\t\tspan other #{v1}\n";
+	}
+	pug += "\tul\n\t\teach i in [1, 2, 3, 4, 5]\n\t\t\tli #{i} of #{name}\n";
+	xxx::pug::template_t const compiled{pug};
+	xxx::pug::options_t		   options;
+	options.compact = true;
+
+	std::printf("  variables   us per render\n");
+	for (std::size_t const count: {25u, 100u, 1000u, 10000u}) {
+		std::vector<std::string> names;
+		for (std::size_t i = 0u; i < count; ++i) names.push_back("v" + std::to_string(i));
+		xxx::pug::variables_t variables{{"name", "world"}};
+		for (std::size_t i = 0u; i < count; ++i) variables.emplace(names[i], std::to_string(i % 7u));
+
+		int const  renders = 10000u <= count ? 3 : 1000u <= count ? 20 : 200;
+		auto const begin   = std::chrono::steady_clock::now();
+		for (int r = 0; r < renders; ++r) (void)compiled.render(variables, options);
+		auto const us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+		std::printf("  %9zu   %13.1f\n", count + 1u, us / renders);
+	}
+}
@@ -0,0 +1,163 @@
+///	@file
+///	@brief		pug++  - C API for embedding
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+
+#include "libpug.h"
+#include "pug.hpp"
+#include "pug_json.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+///	@brief	Engine having variables and options.
+struct pug_engine {
+	xxx::pug::json::document_t		  variables;	///< @brief	Variables with their names.
+	xxx::pug::options_t				  options;		///< @brief	Rendering options.
+	pug_error						  error;		///< @brief	Error code of the last call.
+	std::string						  message;		///< @brief	Message of the last error.
+	std::string						  html;			///< @brief	HTML rendered but not copied yet.
+	std::uint64_t					  rendered;		///< @brief	Serial number of the template of the @p html. Zero means it is not available.
+};
+
+///	@brief	Compiled template.
+struct pug_template {
+	xxx::pug::template_t compiled;	  ///< @brief	Compiled template.
+	std::uint64_t		 serial;	  ///< @brief	Serial number to identify the template even if its address is reused.
+};
+
+namespace {
+
+///	@brief	Serial number of the last compiled template.
+std::atomic<std::uint64_t> last_serial{0u};
+
+///	@brief	Calls the @p f and translates its exceptions to the error code of the @p engine.
+///	@tparam		F	Type of the @p f.
+///	@param[in]	engine	Engine to keep the error.
+///	@param[in]	f		Function to call.
+///	@return		Error code.
+template<typename F>
+pug_error call(pug_engine* engine, F const& f) noexcept {
+	if (! engine) return PUG_ERROR_INVALID_ARGUMENT;
+	auto const report = [engine](pug_error error, char const* message) noexcept {
+		engine->error = error;
+		try {
+			engine->message = message;
+		} catch (...) {
+			engine->message.clear();
+		}
+		return error;
+	};
+	try {
+		return report(f(), "");
+	} catch (xxx::pug::ex::syntax_error const& e) {
+		return report(PUG_ERROR_SYNTAX, e.what());
+	} catch (xxx::pug::ex::io_error const& e) {
+		return report(PUG_ERROR_IO, e.what());
+	} catch (std::filesystem::filesystem_error const& e) {
+		return report(PUG_ERROR_IO, e.what());
+	} catch (std::invalid_argument const& e) {
+		return report(PUG_ERROR_INVALID_ARGUMENT, e.what());
+	} catch (std::bad_alloc const& e) {
+		return report(PUG_ERROR_NO_MEMORY, e.what());
+	} catch (std::exception const& e) {
+		return report(PUG_ERROR_UNEXPECTED, e.what());
+	} catch (...) {
+		return report(PUG_ERROR_UNEXPECTED, "");
+	}
+}
+
+}	 // namespace
+
+extern "C" {
+
+pug_engine* pug_engine_create(void) {
+	try {
+		return new pug_engine{{}, {}, PUG_OK, {}, {}, 0u};
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void pug_engine_destroy(pug_engine* engine) {
+	delete engine;
+}
+
+pug_error pug_engine_set_variable(pug_engine* engine, char const* name, char const* value) {
+	return call(engine, [engine, name, value] {
+		if (! name || ! *name || ! value) throw std::invalid_argument(__func__);
+		auto& variables = engine->variables;
+		if (auto const itr = variables.variables.find(name); itr != variables.variables.end()) {
+			itr->second = value;
+		} else {
+			variables.variables.emplace(variables.names.emplace_back(name), value);
+		}
+		engine->rendered = 0u;
+		return PUG_OK;
+	});
+}
+
+pug_error pug_engine_clear_variables(pug_engine* engine) {
+	return call(engine, [engine] {
+		engine->variables = xxx::pug::json::document_t{};
+		engine->rendered  = 0u;
+		return PUG_OK;
+	});
+}
+
+pug_error pug_engine_set_compact(pug_engine* engine, int compact) {
+	return call(engine, [engine, compact] {
+		engine->options.compact = compact != 0;
+		engine->rendered		= 0u;
+		return PUG_OK;
+	});
+}
+
+pug_error pug_engine_last_error(pug_engine const* engine) {
+	return engine ? engine->error : PUG_ERROR_INVALID_ARGUMENT;
+}
+
+char const* pug_engine_last_message(pug_engine const* engine) {
+	return engine ? engine->message.c_str() : "";
+}
+
+pug_error pug_template_compile_string(pug_engine* engine, char const* pug, size_t size, char const* path, pug_template** compiled) {
+	return call(engine, [pug, size, path, compiled] {
+		if ((! pug && size != 0u) || ! compiled) throw std::invalid_argument(__func__);
+		*compiled = new pug_template{xxx::pug::template_t{std::string(pug ? pug : "", size), path ? path : "./"}, ++last_serial};
+		return PUG_OK;
+	});
+}
+
+pug_error pug_template_compile_file(pug_engine* engine, char const* path, pug_template** compiled) {
+	return call(engine, [path, compiled] {
+		if (! path || ! compiled) throw std::invalid_argument(__func__);
+		*compiled = new pug_template{xxx::pug::compile_file(path), ++last_serial};
+		return PUG_OK;
+	});
+}
+
+void pug_template_destroy(pug_template* compiled) {
+	delete compiled;
+}
+
+pug_error pug_render(pug_engine* engine, pug_template const* compiled, char* buffer, size_t* size) {
+	return call(engine, [engine, compiled, buffer, size] {
+		if (! compiled || ! size || (! buffer && *size != 0u)) throw std::invalid_argument(__func__);
+		if (engine->rendered != compiled->serial) {
+			engine->html	 = compiled->compiled.render(engine->variables.variables, engine->options);
+			engine->rendered = compiled->serial;
+		}
+		auto const capacity = std::exchange(*size, engine->html.size());
+		if (capacity < engine->html.size()) return PUG_ERROR_BUFFER_TOO_SMALL;	// Keeps the HTML for the next call.
+
+		if (! engine->html.empty()) {
+			std::memcpy(buffer, engine->html.data(), engine->html.size());
+		}
+		engine->html.clear();
+		engine->rendered = 0u;
+		return PUG_OK;
+	});
+}
+
+}	 // extern "C"
@@ -0,0 +1,113 @@
+/*
+ *	@file
+ *	@brief		pug++  - C API for embedding
+ *	@author		Mura
+ *	@copyright	(c) 2022-, Mura.
+ *
+ *	Rendering writes HTML into a buffer owned by the caller:
+ *		-#	Call pug_render() with the capacity of the buffer in the @p size, which may be zero with the null buffer.
+ *		-#	If it returns PUG_ERROR_BUFFER_TOO_SMALL, the @p size is set to the required size.
+ *			Reallocate the buffer and call it again with the same template.
+ *			The HTML kept by the engine is copied without rendering again unless variables are modified.
+ *
+ *	An engine must not be used by several threads at once.
+ *	A template is immutable, so that it can be rendered by several engines at once.
+ */
+
+#ifndef xxx_LIBPUG_H_
+#define xxx_LIBPUG_H_
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#if defined(xxx_LIBPUG_BUILD)
+#define PUG_API __declspec(dllexport)
+#else
+#define PUG_API __declspec(dllimport)
+#endif
+#else
+#define PUG_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*	@brief	Error codes. */
+typedef enum pug_error {
+	PUG_OK						= 0,	/*	Succeeded. */
+	PUG_ERROR_INVALID_ARGUMENT	= 1,	/*	Null handle or invalid argument. */
+	PUG_ERROR_SYNTAX			= 2,	/*	Syntax error of the pug. */
+	PUG_ERROR_IO				= 3,	/*	I/O error such as missing file. */
+	PUG_ERROR_BUFFER_TOO_SMALL	= 4,	/*	Buffer is too small to write the HTML. */
+	PUG_ERROR_NO_MEMORY			= 5,	/*	Memory allocation failed. */
+	PUG_ERROR_UNEXPECTED		= 6		/*	Unexpected error. */
+} pug_error;
+
+/*	@brief	Engine having variables and options. */
+typedef struct pug_engine pug_engine;
+/*	@brief	Compiled template. */
+typedef struct pug_template pug_template;
+
+/*	@brief	Creates an engine.
+ *	@return		The engine. It returns null if memory allocation failed. */
+PUG_API pug_engine* pug_engine_create(void);
+/*	@brief	Destroys the engine.
+ *	@param[in]	engine	Engine to destroy. Null is ignored. */
+PUG_API void pug_engine_destroy(pug_engine* engine);
+/*	@brief	Sets a variable.
+ *	@param[in]	engine	Engine.
+ *	@param[in]	name	Name of the variable. Empty is invalid.
+ *	@param[in]	value	Value of the variable.
+ *	@return		Error code. */
+PUG_API pug_error pug_engine_set_variable(pug_engine* engine, char const* name, char const* value);
+/*	@brief	Clears all the variables.
+ *	@param[in]	engine	Engine.
+ *	@return		Error code. */
+PUG_API pug_error pug_engine_clear_variables(pug_engine* engine);
+/*	@brief	Sets whether it emits minimal whitespaces or not.
+ *	@param[in]	engine	Engine.
+ *	@param[in]	compact	Non-zero emits minimal whitespaces without indents.
+ *	@return		Error code. */
+PUG_API pug_error pug_engine_set_compact(pug_engine* engine, int compact);
+/*	@brief	Gets the error code of the last call with the engine.
+ *	@param[in]	engine	Engine.
+ *	@return		Error code. */
+PUG_API pug_error pug_engine_last_error(pug_engine const* engine);
+/*	@brief	Gets the message of the last error with the engine.
+ *	@param[in]	engine	Engine.
+ *	@return		Message. It is available until the next call with the engine. */
+PUG_API char const* pug_engine_last_message(pug_engine const* engine);
+
+/*	@brief	Compiles a pug string.
+ *	@param[in]	engine		Engine to report errors.
+ *	@param[in]	pug			Source formatted in pug.
+ *	@param[in]	size		Size of the @p pug.
+ *	@param[in]	path		Path to resolve included files. Null means the working directory.
+ *	@param[out]	compiled	Compiled template.
+ *	@return		Error code. */
+PUG_API pug_error pug_template_compile_string(pug_engine* engine, char const* pug, size_t size, char const* path, pug_template** compiled);
+/*	@brief	Compiles a pug file.
+ *	@param[in]	engine		Engine to report errors.
+ *	@param[in]	path		Path of the pug file.
+ *	@param[out]	compiled	Compiled template.
+ *	@return		Error code. */
+PUG_API pug_error pug_template_compile_file(pug_engine* engine, char const* path, pug_template** compiled);
+/*	@brief	Destroys the template.
+ *	@param[in]	compiled	Template to destroy. Null is ignored. */
+PUG_API void pug_template_destroy(pug_template* compiled);
+
+/*	@brief	Renders the template with variables of the engine into the buffer.
+ *		The HTML is not terminated by the null character.
+ *	@param[in]		engine		Engine.
+ *	@param[in]		compiled	Template to render.
+ *	@param[out]		buffer		Buffer to write. It may be null if the @p size is zero.
+ *	@param[in,out]	size		Capacity of the @p buffer as input, and size of the HTML as output.
+ *	@return		Error code. */
+PUG_API pug_error pug_render(pug_engine* engine, pug_template const* compiled, char* buffer, size_t* size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* xxx_LIBPUG_H_ */
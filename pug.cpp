@@ -4,6 +4,20 @@
 ///	@copyright	(c) 2022-, Mura.
 
 #include "pug.hpp"
+#include "pug_cache.hpp"
+#include "pug_json.hpp"
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <optional>
+#if defined(xxx_PUG_ZLIB)
+#include <zlib.h>
+#endif	  // xxx_PUG_ZLIB
+#if __has_include(<sys/un.h>)
+#include "pug_serve.hpp"
+#include <csignal>
+#endif
 
 namespace {
 
@@ -13,8 +27,33 @@ inline std::string get_usage() {
 	return "===[ pug2html ]===  (c) 2022-, Mura.\n"
 		   "\n"
 		   "[USAGE] $ pug  (options)  {pug file}\n"
+		   "  A pug file '-' means the standard input, whose HTML is written into the standard output by default.\n"
 		   "[options]\n"
-		   "  -h     : shows this usage only\n";
+		   "  -h                  : shows this usage only\n"
+		   "  --compact           : emits minimal whitespaces without indents\n"
+		   "  -o {file}           : path of the HTML instead of the default; '-' means the standard output\n"
+		   "  -C {dir}            : changes the working directory before reading and writing files\n"
+		   "  --gzip[=level]      : writes compressed HTML (.html.gz) alongside HTML\n"
+		   "  --gzip-only[=level] : writes compressed HTML (.html.gz) instead of HTML\n"
+		   "  -MD                 : writes Makefile-style dependencies of the output (.d)\n"
+		   "  -MF {file}          : path of the dependencies instead of the default\n"
+		   "  --cache-dir=dir     : copies HTML cached in the directory if no inputs are modified\n"
+		   "\n"
+		   "[USAGE] $ pug  --data {records}  --out-pattern {pattern}  (options)  {pug file}\n"
+		   "  It translates the pug file for each record of JSON Lines, which is a flat JSON object per line, in parallel.\n"
+		   "  Each '{name}' in the pattern is replaced with the variable of the record; e.g., 'out/{id}.html'.\n"
+		   "  Records '-' means the standard input. The '--compact', '--gzip' and '--gzip-only' options are available.\n"
+		   "\n"
+		   "[USAGE] $ pug  --check  {pug files or directories}\n"
+		   "  It validates pug files and their includes in parallel without writing HTML, and reports all the errors.\n"
+		   "\n"
+		   "[USAGE] $ pug  --serve  (options)  {socket}\n"
+		   "  It runs as a daemon to translate pug files requested through the Unix domain socket.\n"
+		   "[options]\n"
+		   "  --compact           : emits minimal whitespaces without indents\n"
+		   "  --workers=count     : count of workers to serve clients concurrently\n"
+		   "  --timeout=ms        : responds an error if rendering a request takes longer\n"
+		   "  --max-iterations=n  : responds an error if loops of a request iterate more\n";
 }
 
 ///	@brief	Gets a usage string of this program.
@@ -29,17 +68,102 @@ inline bool contains(C const& container, I const& item) noexcept {
 	return std::ranges::find(container, item) != std::ranges::cend(container);
 }
 
+///	@brief	Gets the value of the option formed as either '--name' or '--name=value'.
+///	@param[in]	arguments	All the arguments.
+///	@param[in]	name		Name of the option including the '--' indicator.
+///	@return		It returns the value of the option, which is empty if the value is omitted;
+///				otherwise, it returns null if the option is not specified.
+inline std::optional<std::string_view> get_option(std::vector<std::string_view> const& arguments, std::string_view name) {
+	for (auto const& a: arguments) {
+		if (a == name) return std::string_view{};
+		if (a.starts_with(name) && a.substr(name.size()).starts_with('=')) return a.substr(name.size() + 1u);
+	}
+	return std::nullopt;
+}
+
+///	@brief	Options that take the following argument as their value.
+static std::string_view const Valued_options[]{"-MF", "-o", "-C", "--data", "--out-pattern"};
+
+///	@brief	Gets the value of the option formed as either '-Xvalue' or '-X value'.
+///		A long option that starts with '--' is formed as either '--name=value' or '--name value'.
+///	@param[in]	arguments	All the arguments.
+///	@param[in]	name		Name of the option including the '-' indicator.
+///	@return		It returns the value of the option; otherwise, it returns null if the option is not specified or its value is missing.
+inline std::optional<std::string_view> get_valued_option(std::vector<std::string_view> const& arguments, std::string_view name) {
+	for (auto itr = arguments.cbegin(); itr != arguments.cend(); ++itr) {
+		if (*itr == name) return std::next(itr) == arguments.cend() ? std::nullopt : std::optional<std::string_view>{*std::next(itr)};
+		if (! itr->starts_with(name)) continue;
+		if (auto const value = itr->substr(name.size()); ! name.starts_with("--")) {
+			return value;
+		} else if (value.starts_with('=')) {
+			return value.substr(1u);
+		}
+	}
+	return std::nullopt;
+}
+
 ///	@brief	Gets the arguments excluding options that starts with the '-' indicator.
 ///		This function aims to handle the arguments of this program.
 ///		- An argument that starts with '-' is an 'option', which is a directive to the program.
 ///		- An argument that does not start with '-' is an 'argument', which is a target of the program.
+///		- An argument following a valued option such as '-MF' is the value of the option.
 ///		A file name that starts with '-' cannot be specified.
-///		Single '-' character that means piped input is not supported. Such argument is dealt as an option.
+///		Single '-' character is an argument, which means the standard input.
 ///	@param[in]	arguments	All the arguments.
 ///	@return		The arguments.
 inline std::vector<std::string_view> get_arguments(std::vector<std::string_view> const& arguments) {
-	auto args = arguments | std::views::filter([](auto const& a) { return ! a.starts_with('-'); }) | std::views::common;
-	return std::vector<std::string_view>(args.begin(), args.end());
+	std::vector<std::string_view> args;
+	for (auto itr = arguments.cbegin(); itr != arguments.cend(); ++itr) {
+		if (contains(Valued_options, *itr)) {
+			if (std::next(itr) == arguments.cend()) break;
+			++itr;	  // Skips the value.
+		} else if (*itr == "-" || ! itr->starts_with('-')) {
+			args.push_back(*itr);
+		}
+	}
+	return args;
+}
+
+///	@brief	Escapes the @p path as a word of Makefile.
+///	@param[in]	path	Path to escape.
+///	@return		Escaped path.
+inline std::string escape_make(std::filesystem::path const& path) {
+	std::string out;
+	for (auto const c: path.generic_string()) {
+		if (c == ' ' || c == '#' || c == '\\') {
+			out += '\\';
+		} else if (c == '$') {
+			out += '$';
+		}
+		out += c;
+	}
+	return out;
+}
+
+///	@brief	Writes the Makefile-style dependencies.
+///		Build systems, such as Make and Ninja, rebuild the @p targets if any of the @p dependencies is modified.
+///	@param[in]	path			Path of the dependency file.
+///	@param[in]	targets			Output files.
+///	@param[in]	dependencies	Input files. Duplicated files are written only once.
+///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+inline void write_depfile(std::filesystem::path const& path, std::vector<std::filesystem::path> const& targets, std::vector<std::filesystem::path> const& dependencies) {
+	try {
+		std::ofstream ofs;
+		ofs.exceptions(std::ios::badbit | std::ios::failbit);
+		ofs.open(path, std::ios::out | std::ios::binary);
+		for (bool first = true; auto const& a: targets) {
+			ofs << (first ? "" : " ") << escape_make(a);
+			first = false;
+		}
+		ofs << ":";
+		std::set<std::filesystem::path> written;
+		for (auto const& a: dependencies) {
+			if (written.insert(a.lexically_normal()).second) ofs << " \\\n  " << escape_make(a);
+		}
+		ofs << '\n';
+	} catch (std::ios_base::failure const& e) {
+		throw xxx::pug::ex::io_error(path.string(), e.code());
+	}
 }
 
 ///	@brief	Gets an output HTML path from the original pug.
@@ -49,23 +173,330 @@ inline std::string get_ouput_filename(std::string_view path) {
 	return std::filesystem::path{path}.replace_extension(".html").string();
 }
 
-///	@brief	Outputs the @p context into the file of the @p path.
-///		If an exception occurred, state of the file was unspecified.
+///	@brief	Size of a chunk to write at once.
+static std::size_t const Chunk_size{64u * 1024u};
+
+///	@brief	Reads the whole standard input.
+///		It is read chunk by chunk instead of character by character.
+///	@return		Content of the standard input.
+///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+inline std::string read_stdin() {
+	std::string		  source;
+	std::vector<char> buffer(Chunk_size);
+	while (std::cin.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || 0 < std::cin.gcount()) {
+		source.append(buffer.data(), static_cast<std::size_t>(std::cin.gcount()));
+	}
+	if (std::cin.bad()) throw xxx::pug::ex::io_error("-", std::make_error_code(std::errc::io_error));
+	return source;
+}
+
+#if defined(xxx_PUG_ZLIB)
+///	@brief	Writer of a gzip file.
+///		It compresses the content as it is written.
+class gzip_writer_t {
+public:
+	///	@brief	Compresses and writes the @p content.
+	///	@param[in]	content		Content to write.
+	///	@throws		xxx::pug::ex::io_error		It throws the exception with the path of the file if an I/O error occurred.
+	void write(std::string_view content) { deflate(content, Z_NO_FLUSH); }
+	///	@brief	Flushes the remaining compressed data and the trailer.
+	///	@throws		xxx::pug::ex::io_error		It throws the exception with the path of the file if an I/O error occurred.
+	void finish() { deflate(std::string_view{}, Z_FINISH); }
+
+	///	@brief	Constructor.
+	///	@param[in]	path	Path of output file.
+	///	@param[in]	level	Compression level.
+	///	@throws		xxx::pug::ex::io_error		It throws the exception with the path of the file if an I/O error occurred.
+	gzip_writer_t(std::filesystem::path const& path, int level) :
+		path_{path}, ofs_{path, std::ios::out | std::ios::binary}, stream_{} {
+		if (! ofs_) throw xxx::pug::ex::io_error(path_, std::make_error_code(std::errc::io_error));
+		// Window bits greater than 15 make zlib to write the gzip header and trailer.
+		if (deflateInit2(&stream_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			throw xxx::pug::ex::io_error(path_, std::make_error_code(std::errc::io_error));
+		}
+	}
+	///	@brief	Destructor.
+	~gzip_writer_t() { deflateEnd(&stream_); }
+	gzip_writer_t(gzip_writer_t const&)			   = delete;
+	gzip_writer_t& operator=(gzip_writer_t const&) = delete;
+
+private:
+	///	@brief	Compresses the @p content and writes the result.
+	///	@param[in]	content		Content to compress.
+	///	@param[in]	flush		Flush mode of zlib.
+	void deflate(std::string_view content, int flush) {
+		char buffer[Chunk_size];
+		stream_.next_in	 = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+		stream_.avail_in = static_cast<uInt>(content.size());
+		do {
+			stream_.next_out  = reinterpret_cast<Bytef*>(buffer);
+			stream_.avail_out = static_cast<uInt>(sizeof(buffer));
+			if (auto const r = ::deflate(&stream_, flush); r == Z_STREAM_ERROR) {
+				throw xxx::pug::ex::io_error(path_, std::make_error_code(std::errc::io_error));
+			}
+			if (! ofs_.write(buffer, static_cast<std::streamsize>(sizeof(buffer) - stream_.avail_out))) {
+				throw xxx::pug::ex::io_error(path_, std::make_error_code(std::errc::io_error));
+			}
+		} while (stream_.avail_out == 0u);
+		if (flush == Z_FINISH && ! ofs_.flush()) throw xxx::pug::ex::io_error(path_, std::make_error_code(std::errc::io_error));
+	}
+
+	std::filesystem::path path_;	  ///< @brief	Path of output file.
+	std::ofstream		  ofs_;		  ///< @brief	Output file.
+	z_stream			  stream_;	  ///< @brief	Stream of zlib.
+};
+#endif	  // xxx_PUG_ZLIB
+
+///	@brief	Outputs the @p chunks into the file of the @p path.
+///		The HTML and its compressed file are written chunk by chunk as they are rendered.
+///		If an exception occurred, the files are removed.
+///	@tparam		R			Type of the @p chunks.
 ///	@param[in]	path		Path of output file.
-///	@param[in]	context		Context to output.
+///	@param[in]	chunks		Chunks of HTML to output.
+///	@param[in]	html		Whether it writes the HTML file or not.
+///	@param[in]	gzip		Compression level of the gzip file. Null means no gzip file is written.
 ///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
-inline void output(std::filesystem::path const& path, std::string_view content) {
+template<typename R>
+inline void output(std::filesystem::path const& path, R&& chunks, bool html = true, std::optional<int> gzip = std::nullopt) {
+	auto const gz = std::filesystem::path{path} += ".gz";
+	auto const remove = [&] {
+		std::error_code ec;
+		if (html) std::filesystem::remove(path, ec);
+		if (gzip) std::filesystem::remove(gz, ec);
+	};
 	try {
 		std::ofstream ofs;
 		ofs.exceptions(std::ios::badbit | std::ios::failbit);
-		ofs.open(path, std::ios::out | std::ios::binary);
+		if (html) {
+			ofs.open(path, std::ios::out | std::ios::binary);
+		}
+#if defined(xxx_PUG_ZLIB)
+		std::optional<gzip_writer_t> gzw;
+		if (gzip) {
+			gzw.emplace(gz, *gzip);
+		}
+#else
+		if (gzip) throw xxx::pug::ex::io_error(gz, std::make_error_code(std::errc::not_supported));
+#endif	  // xxx_PUG_ZLIB
 
-		std::ranges::copy(content, std::ostreambuf_iterator<char>(ofs));
+		for (auto const& chunk: chunks) {
+			if (html) {
+				ofs.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+			}
+#if defined(xxx_PUG_ZLIB)
+			if (gzw) {
+				gzw->write(chunk);
+			}
+#endif	  // xxx_PUG_ZLIB
+		}
+#if defined(xxx_PUG_ZLIB)
+		if (gzw) {
+			gzw->finish();
+		}
+#endif	  // xxx_PUG_ZLIB
+	} catch (xxx::pug::ex::io_error const&) {
+		// Errors of the compressed file or the included files have their own paths.
+		remove();
+		throw;
 	} catch (std::ios_base::failure const& e) {
-		throw xxx::pug::ex::io_error(path.string(), e.code());
+		remove();
+		throw xxx::pug::ex::io_error(path, e.code());
+	} catch (...) {
+		remove();
+		throw;
+	}
+}
+
+///	@brief	Outputs the @p chunks into the @p os stream such as the standard output.
+///		Each chunk is written at once, so that it bypasses the buffer of the stream if it is larger than the buffer.
+///	@tparam		R			Type of the @p chunks.
+///	@param[in]	os			Stream to output.
+///	@param[in]	chunks		Chunks of HTML to output.
+///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+template<typename R>
+inline void output(std::ostream& os, R&& chunks) {
+	for (auto const& chunk: chunks) {
+		if (! os.write(chunk.data(), static_cast<std::streamsize>(chunk.size()))) break;
+	}
+	if (! os.flush()) throw xxx::pug::ex::io_error("-", std::make_error_code(std::errc::io_error));
+}
+
+///	@brief	Gets the compression level from the value of the option.
+///	@param[in]	value	Value of the option. Empty means the default level.
+///	@return		Compression level. It returns null if the @p value is not a level from 1 to 9.
+inline std::optional<int> get_gzip_level(std::string_view value) noexcept {
+	int const Default_level{6};
+	if (value.empty()) return Default_level;
+
+	int level{};
+	if (auto const [p, ec] = std::from_chars(value.data(), value.data() + value.size(), level); ec != std::errc{} || p != value.data() + value.size() || level < 1 || 9 < level) {
+		return std::nullopt;
+	}
+	return level;
+}
+
+///	@brief	Validates pug files in parallel without rendering.
+///		Errors are reported as 'file:line: message' in order of files and lines.
+///		An error of a file included by several pug files is reported once.
+///	@param[in]	paths	Pug files or directories, whose pug files are validated recursively.
+///	@return		It returns true if no errors are found; otherwise, it returns false.
+inline bool check(std::vector<std::string_view> const& paths) {
+	std::vector<std::filesystem::path> files;
+	for (auto const& a: paths) {
+		if (std::filesystem::is_directory(a)) {
+			for (auto const& e: std::filesystem::recursive_directory_iterator{a}) {
+				if (e.is_regular_file() && e.path().extension() == ".pug") files.push_back(e.path());
+			}
+		} else {
+			files.emplace_back(a);
+		}
+	}
+
+	std::vector<std::vector<xxx::pug::diagnostic_t>> results(files.size());
+	{
+		std::atomic<std::size_t>  next{};
+		std::vector<std::jthread> workers(std::min<std::size_t>(files.size(), std::max(1u, std::thread::hardware_concurrency())));
+		std::ranges::generate(workers, [&] {
+			return std::jthread{[&] {
+				for (std::size_t i = next++; i < files.size(); i = next++) {
+					try {
+						results[i] = xxx::pug::check_file(files[i]);
+					} catch (std::exception const& e) {
+						results[i].push_back({files[i], 0u, e.what()});
+					}
+				}
+			}};
+		});
+	}
+
+	std::set<xxx::pug::diagnostic_t> errors;
+	for (auto const& a: results) {
+		errors.insert(a.cbegin(), a.cend());
+	}
+	for (auto const& a: errors) {
+		std::cerr << a.path.string() << ':' << a.line << ": " << a.message << '\n';
+	}
+	std::clog << "check: " << files.size() << " files, " << errors.size() << " errors\n";
+	return errors.empty();
+}
+
+///	@brief	Gets the output path of a record from the @p pattern.
+///		Each '{name}' in the @p pattern is replaced with the variable of the name.
+///	@param[in]	pattern		Pattern of the output path.
+///	@param[in]	variables	Variables of the record.
+///	@return		Output path.
+///	@throws		xxx::pug::ex::syntax_error	It throws the exception if a variable is missing or it is not a file name.
+inline std::filesystem::path get_output_path(std::string_view pattern, xxx::pug::variables_t const& variables) {
+	std::string out;
+	for (auto pos = pattern.find('{'); pos != std::string_view::npos; pos = pattern.find('{')) {
+		auto const end = pattern.find('}', pos);
+		if (end == std::string_view::npos) throw xxx::pug::ex::syntax_error("unterminated '{' of the pattern");
+		auto const name = pattern.substr(pos + 1u, end - pos - 1u);
+		auto const itr	= variables.find(name);
+		if (itr == variables.cend()) throw xxx::pug::ex::syntax_error("missing '" + std::string{name} + "' of the pattern");
+		// Values never escape from the directory of the pattern.
+		if (auto const& v = itr->second; v.empty() || v == "." || v == ".." || v.find_first_of("/\\") != std::string::npos) {
+			throw xxx::pug::ex::syntax_error("invalid '" + std::string{name} + "' of the pattern");
+		}
+		out.append(pattern.substr(0u, pos)).append(itr->second);
+		pattern = pattern.substr(end + 1u);
+	}
+	return out.append(pattern);
+}
+
+///	@brief	Translates the template for each record of the JSON Lines in parallel.
+///		Records are read line by line into a bounded queue, so that memory is bounded regardless of the count of records.
+///		Workers parse the records and write their outputs chunk by chunk.
+///		A failed record is reported as 'records:line: message', and the others are still translated.
+///	@param[in]	compiled	Compiled template.
+///	@param[in]	records		Stream of the JSON Lines.
+///	@param[in]	name		Name of the records to report.
+///	@param[in]	pattern		Pattern of the output paths.
+///	@param[in]	options		Rendering options.
+///	@param[in]	html		Whether it writes the HTML files or not.
+///	@param[in]	gzip		Compression level of the gzip files. Null means no gzip files are written.
+///	@return		It returns true if all the records are translated; otherwise, it returns false.
+inline bool render_batch(xxx::pug::template_t const& compiled, std::istream& records, std::string_view name, std::string_view pattern, xxx::pug::options_t const& options, bool html, std::optional<int> gzip) {
+	auto const						   workers = std::max(1u, std::thread::hardware_concurrency());
+	std::size_t const				   capacity{4u * workers};
+	std::mutex						   mutex;
+	std::condition_variable			   readable, writable;
+	std::deque<std::pair<std::size_t, std::string>> queue;	  // Line number and record.
+	bool							   finished{};
+	std::atomic<std::size_t>		   pages{}, errors{};
+
+	auto const start = std::chrono::steady_clock::now();
+	{
+		std::vector<std::jthread> threads(workers);
+		std::ranges::generate(threads, [&] {
+			return std::jthread{[&] {
+				for (;;) {
+					std::unique_lock lock{mutex};
+					readable.wait(lock, [&] { return ! queue.empty() || finished; });
+					if (queue.empty()) return;
+					auto const [line, record] = std::move(queue.front());
+					queue.pop_front();
+					lock.unlock();
+					writable.notify_one();
+
+					try {
+						auto const doc	= xxx::pug::json::parse_object(record);
+						auto const path = get_output_path(pattern, doc.variables);
+						if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path());
+						output(path, xxx::pug::render_chunks(compiled, doc.variables, options, Chunk_size), html, gzip);
+						++pages;
+					} catch (std::exception const& e) {
+						++errors;
+						std::lock_guard guard{mutex};
+						std::cerr << name << ':' << line << ": " << e.what() << '\n';
+					}
+				}
+			}};
+		});
+
+		std::size_t line = 0u;
+		for (std::string record; std::getline(records, record);) {
+			++line;
+			if (record.find_first_not_of(" \t\r") == std::string::npos) continue;	 // Blank line.
+			std::unique_lock lock{mutex};
+			writable.wait(lock, [&] { return queue.size() < capacity; });
+			queue.emplace_back(line, std::move(record));
+			lock.unlock();
+			readable.notify_one();
+		}
+		{
+			std::lock_guard lock{mutex};
+			finished = true;
+		}
+		readable.notify_all();
 	}
+	auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::clog << "batch: " << pages << " pages, " << errors << " errors, " << static_cast<std::size_t>(pages / std::max(seconds, 1e-9)) << " pages/s\n";
+	return errors == 0u && ! records.bad();
 }
 
+#if __has_include(<sys/un.h>)
+///	@brief	Running daemon to stop by signals.
+xxx::pug::serve::server_t* server{};
+
+///	@brief	Runs as a daemon until it is interrupted.
+///	@param[in]	socket		Path of the socket.
+///	@param[in]	workers		Count of the workers.
+///	@param[in]	options		Rendering options.
+///	@param[in]	limits		Resource limits of each request.
+inline void serve(std::filesystem::path const& socket, std::size_t workers, xxx::pug::options_t const& options, xxx::pug::limits_t const& limits) {
+	xxx::pug::serve::server_t daemon{socket, workers, options, limits};
+	server = &daemon;
+	for (auto const sig: {SIGINT, SIGTERM}) {
+		std::signal(sig, [](int) {
+			if (server) server->stop();
+		});
+	}
+	daemon.run();
+	server = nullptr;
+}
+#endif
+
 }	 // namespace
 
 ///	@name	err
@@ -76,6 +507,7 @@ static char const No_pugfile[]		 = "No pug file is specified.";
 static char const Several_pugfiles[] = "Several pug files are specified.";
 static char const Syntax_error[]	 = "Syntax error found.";
 static char const IO_failed[]		 = "I/O error occurred.";
+static char const Invalid_option[]	 = "Invalid option is specified.";
 }	 // namespace err
 
 ///	@brief	Main entry of this program.
@@ -96,12 +528,139 @@ int main(int ac, char* av[]) {
 		} else if (auto const paths = get_arguments(args); paths.empty()) {
 			std::clog << get_usage() << '\n'
 					  << err::No_pugfile << '\n';
+		} else if (contains(args, "--check")) {
+			return check(paths) ? 0 : -1;
 		} else if (1u < paths.size()) {
 			std::clog << get_usage() << '\n'
 					  << err::Several_pugfiles << '\n';
 		} else {
-			std::string const pug = xxx::pug::pug_file(paths.front());
-			output(get_ouput_filename(paths.front()), pug);
+			auto const gzip		 = get_option(args, "--gzip");
+			auto const gzip_only = get_option(args, "--gzip-only");
+			auto const level	 = gzip ? get_gzip_level(*gzip) : gzip_only ? get_gzip_level(*gzip_only) : std::optional<int>{};
+			if ((gzip && gzip_only) || ((gzip || gzip_only) && ! level)) {
+				std::clog << get_usage() << '\n'
+						  << err::Invalid_option << '\n';
+				return -1;
+			}
+
+			xxx::pug::options_t options;
+			options.compact = contains(args, "--compact");
+
+			if (contains(args, "--serve")) {
+#if __has_include(<sys/un.h>)
+				// It parses a positive count of the option if specified.
+				auto const get_count = [&args](std::string_view name, std::size_t& count) {
+					auto const value = get_option(args, name);
+					if (! value) return true;
+					auto const [p, ec] = std::from_chars(value->data(), value->data() + value->size(), count);
+					return ec == std::errc{} && p == value->data() + value->size() && count != 0u;
+				};
+				std::size_t		   workers = std::thread::hardware_concurrency();
+				std::size_t		   timeout = 0u;
+				xxx::pug::limits_t limits;
+				if (! get_count("--workers", workers) || ! get_count("--timeout", timeout) || ! get_count("--max-iterations", limits.iterations)) {
+					std::clog << get_usage() << '\n'
+							  << err::Invalid_option << '\n';
+					return -1;
+				}
+				if (timeout != 0u) limits.timeout = std::chrono::milliseconds{timeout};
+				serve(paths.front(), workers, options, limits);
+				return 0;
+#else
+				std::clog << get_usage() << '\n'
+						  << err::Invalid_option << '\n';
+				return -1;
+#endif
+			}
+
+			if (std::ranges::any_of(Valued_options, [&args](auto const& a) { return contains(args, a) && ! get_valued_option(args, a); })) {
+				std::clog << get_usage() << '\n'
+						  << err::Invalid_option << '\n';
+				return -1;
+			}
+			if (auto const data = get_valued_option(args, "--data"); data) {
+				auto const pattern = get_valued_option(args, "--out-pattern");
+				if (! pattern || paths.front() == "-" || contains(args, "-o") || contains(args, "-MD") || get_option(args, "--cache-dir")) {
+					std::clog << get_usage() << '\n'
+							  << err::Invalid_option << '\n';
+					return -1;
+				}
+				if (auto const dir = get_valued_option(args, "-C"); dir) {
+					std::filesystem::current_path(*dir);
+				}
+				xxx::pug::template_t const compiled{xxx::pug::compile_file(paths.front())};
+				if (*data == "-") return render_batch(compiled, std::cin, "-", *pattern, options, ! gzip_only, level) ? 0 : -1;
+
+				std::ifstream records;
+				records.open(std::filesystem::path{*data}, std::ios::in | std::ios::binary);
+				if (! records) throw xxx::pug::ex::io_error(std::filesystem::path{*data}, std::make_error_code(std::errc::no_such_file_or_directory));
+				return render_batch(compiled, records, *data, *pattern, options, ! gzip_only, level) ? 0 : -1;
+			}
+			auto const depfile	  = get_valued_option(args, "-MF");
+			auto const from_stdin = paths.front() == "-";
+			auto const to_stdout  = get_valued_option(args, "-o").value_or(from_stdin ? "-" : "") == "-";
+			if (to_stdout && (gzip || gzip_only || contains(args, "-MD") || get_option(args, "--cache-dir"))) {
+				// Only the HTML itself is written into the standard output.
+				std::clog << get_usage() << '\n'
+						  << err::Invalid_option << '\n';
+				return -1;
+			}
+			if (auto const dir = get_valued_option(args, "-C"); dir) {
+				std::filesystem::current_path(*dir);
+			}
+			std::optional<xxx::pug::cache::disk_cache_t> cache;
+			if (auto const dir = get_option(args, "--cache-dir"); dir) {
+				if (dir->empty()) {
+					std::clog << get_usage() << '\n'
+							  << err::Invalid_option << '\n';
+					return -1;
+				}
+				cache.emplace(*dir);
+			}
+
+			// The standard input is dealt as a file named '-' in the working directory to resolve includes.
+			std::vector<std::filesystem::path> dependencies{std::filesystem::path{paths.front()}};
+			if (contains(args, "-MD") || cache) {
+				options.dependencies = &dependencies;
+			}
+
+			auto source = from_stdin ? read_stdin() : xxx::pug::impl::load_file(paths.front());
+			if (to_stdout) {
+				xxx::pug::template_t const compiled{std::move(source), paths.front()};
+				output(std::cout, xxx::pug::render_chunks(compiled, {}, options, Chunk_size));
+				return 0;
+			}
+
+			auto const html = std::string{get_valued_option(args, "-o").value_or(get_ouput_filename(paths.front()))};
+			std::vector<std::pair<std::string, std::filesystem::path>> outputs;
+			if (! gzip_only) outputs.emplace_back(".html", html);
+			if (level) outputs.emplace_back(".html.gz", html + ".gz");
+
+			std::string key;
+			if (cache) {
+				auto const salt = std::string{options.compact ? "compact" : "pretty"} + ':' + std::to_string(gzip_only ? 1 : 0) + ':' + std::to_string(level.value_or(0));
+				key				= xxx::pug::cache::disk_cache_t::key(paths.front(), source, {}, salt);
+				auto const suffixes = outputs | std::views::keys;
+				if (auto const entry = cache->find(key, std::vector<std::string>(suffixes.begin(), suffixes.end())); entry) {
+					for (std::size_t i = 0u; i < outputs.size(); ++i) {
+						std::filesystem::copy_file(entry->files[i], outputs[i].second, std::filesystem::copy_options::overwrite_existing);
+					}
+					dependencies.insert(dependencies.cend(), entry->dependencies.cbegin(), entry->dependencies.cend());
+				}
+			}
+			if (! cache || cache->misses() != 0u) {
+				xxx::pug::template_t const compiled{std::move(source), paths.front()};
+				output(html, xxx::pug::render_chunks(compiled, {}, options, Chunk_size), ! gzip_only, level);
+				if (cache) cache->store(key, outputs, std::vector<std::filesystem::path>(std::next(dependencies.cbegin()), dependencies.cend()));
+			}
+			if (contains(args, "-MD")) {
+				auto const targets = outputs | std::views::values;
+				if (from_stdin) dependencies.erase(dependencies.cbegin());
+				write_depfile(depfile ? std::filesystem::path{*depfile} : std::filesystem::path{html}.replace_extension(".d"), std::vector<std::filesystem::path>(targets.begin(), targets.end()), dependencies);
+			}
+			if (cache) {
+				std::clog << "cache: " << cache->hits() << " hit, " << cache->misses() << " miss\n";
+			}
 			return 0;
 		}
 	} catch (xxx::pug::ex::syntax_error const& e) {
@@ -8,19 +8,37 @@
 
 #include <string_view>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <deque>
 #include <exception>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <list>
 #include <locale>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <numeric>
+#include <optional>
 #include <ranges>
 #include <regex>
+#include <semaphore>
 #include <set>
+#include <span>
 #include <stack>
+#include <stop_token>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -58,11 +76,40 @@ public:
 		std::ios_base::failure(path.string(), code) {}
 };
 
+///	@brief	Exception that a resource limit of a rendering is exceeded.
+class limit_error : public std::runtime_error {
+public:
+	///	@brief	Kind of the limit.
+	enum class kind_t {
+		deadline,		 ///< @brief	The deadline has passed.
+		stopped,		 ///< @brief	Stop has been requested.
+		iterations,		 ///< @brief	Too many iterations of loops.
+		include_depth,	 ///< @brief	Too deep includes and extends.
+		output_size,	 ///< @brief	Too large output.
+		memory,			 ///< @brief	Too much memory.
+	};
+
+	///	@brief	Gets the kind of the exceeded limit.
+	///	@return		The kind of the exceeded limit.
+	kind_t kind() const noexcept { return kind_; }
+
+	///	@brief	Constructor.
+	///	@param[in]	kind		Kind of the exceeded limit.
+	///	@param[in]	message		Message to display.
+	limit_error(kind_t kind, char const* const message) noexcept :
+		std::runtime_error(message), kind_{kind} {}
+
+private:
+	kind_t kind_;	 ///< @brief	Kind of the exceeded limit.
+};
+
 }	 // namespace ex
 namespace impl {
 namespace def {
-static std::set<std::string_view> const void_tags{"br", "hr", "img", "meta", "input", "link", "area", "base", "col", "embed", "param", "source", "track", "wbr"};
-static std::set<std::string_view> const compare_ops{"==", "===", "!=", "!==", "<", "<=", ">", ">="};
+static constexpr std::array<std::string_view, 14u> void_tag_names{"br", "hr", "img", "meta", "input", "link", "area", "base", "col", "embed", "param", "source", "track", "wbr"};
+static constexpr std::array<std::string_view, 8u>  compare_op_names{"==", "===", "!=", "!==", "<", "<=", ">", ">="};
+static std::set<std::string_view> const			   void_tags{void_tag_names.cbegin(), void_tag_names.cend()};
+static std::set<std::string_view> const			   compare_ops{compare_op_names.cbegin(), compare_op_names.cend()};
 static std::set<std::string_view> const assign_ops{
 	"=",
 	"+=",
@@ -77,12 +124,14 @@ static std::string_view const raw_html_sv{"."};
 static std::string_view const folding_sv{"| "};
 static std::string_view const comment_sv{"//-"};
 static std::string_view const raw_comment_sv{"//"};
-static std::string_view const var_sv{"#{"};
+static constexpr std::string_view var_sv{"#{"};
 static std::string_view const default_sv{"default"};
+static constexpr std::array<std::string_view, 9u> directive_prefixes{"//-", "include", "extends", "block", "if", "else", "case", "each", "-"};	 ///< @brief	Leading words of directives.
 
 static std::regex const binary_op_re{R"(^([^ \t]+)[ \t]+([^ \t]+)[ \t]+([^ \t]+)$)"};
 static std::regex const string_re{R"(^(['"])([^'"]*)(['"])$)"};	   // TODO: escape sequence is unsupported.
 static std::regex const integer_re{R"(^(-?[0-9]+)$)"};
+static std::regex const name_re{R"(^[A-Za-z_-][A-Za-z0-9_-]*$)"};
 
 static std::regex const doctype_re{R"(^[dD][oO][cC][tT][yY][pP][eE] ([A-Za-z0-9_]+)$)"};
 static std::regex const tag_re{R"(^([#.]?[A-Za-z_-][A-Za-z0-9_-]*))"};
@@ -107,6 +156,12 @@ static std::regex const include_re{R"(^include[ \t]+([^ ]+)$)"};
 static std::regex const block_re{R"(^block[ \t]+([^ ]+)$)"};
 static std::regex const extends_re{R"(^extends[ \t]+([^ ]+)$)"};
 // TODO: mixin
+
+static std::size_t const parallel_min_iterations{64u};	  ///< @brief	Loops less than it are rendered serially.
+static std::size_t const parallel_chunks_per_worker{8u};	  ///< @brief	Granularity of iterations taken by a worker at once.
+static std::size_t const parallel_batch_iterations{4096u};	  ///< @brief	Iterations of a 'for' loop whose values are taken at once.
+static std::size_t const chunk_size{8u * 1024u};			  ///< @brief	Default threshold of chunked rendering.
+static std::size_t const min_view_size{32u};				  ///< @brief	Views shorter than it are copied rather than referred.
 }	 // namespace def
 
 ///	@brief	Reads the file as string.
@@ -182,17 +237,26 @@ inline std::string_view to_str(std::string_view s, svmatch const& m, std::size_t
 ///	@return		Nested line.
 ///	@warning	Keep original string available because it returns view of the string.
 inline line_t get_line_nest(std::string_view const line) {
-	if (svmatch m; std::regex_match(line.cbegin(), line.cend(), m, def::nest_re)) {
-		return {m.length(1), to_str(line, m, 2)};
-	} else {
-		return {0u, line};
-	}
+	// It is equivalent to the def::nest_re, whose recursive matching overflows the stack by deep indents.
+	auto const nest = std::min(line.find_first_not_of('\t'), line.size());
+	auto const rest = line.substr(nest);
+	return rest.find_first_of("\r\n") == std::string_view::npos ? line_t{nest, rest} : line_t{0u, line};
 }
 
 ///	@brief	Node of nested lines.
 ///	@warning	Keep original string available because it returns view of the string.
 class line_node_t {
 public:
+	///	@brief	Branch of a conditional chain.
+	///		The first element is the condition, which is null for the 'else'.
+	///		The second element is the line of the branch, which is null if the chain is malformed.
+	using branch_t = std::pair<std::optional<std::string_view>, std::shared_ptr<line_node_t const>>;
+	///	@brief	Jump table of a 'case' line.
+	///		The key is the label of 'when', or empty for the 'default'.
+	///		The value is the line whose children are rendered after falling through empty 'when's,
+	///		which is null if it breaks.
+	using cases_t = std::unordered_map<std::string_view, std::shared_ptr<line_node_t const>>;
+
 	///	@brief	Gets the nested level of the node.
 	///	@return		Nested level.
 	nest_t nest() const noexcept { return line_.first; }
@@ -207,12 +271,12 @@ public:
 	/// @param[in]	parent	Parent of the @p line.
 	///	@return		The pushed line.
 	auto& push_nest(line_t const& line, std::shared_ptr<line_node_t> parent) {
-		children_.push_back(std::make_shared<line_node_t>(line, parent));
+		children_.push_back(std::allocate_shared<line_node_t>(children_.get_allocator(), line, parent, children_.get_allocator().resource()));
 		return children_.back();
 	}
 	///	@copydoc	line_node_t::push_nest(line_t const&,std::shared_ptr<line_node_t>)
 	auto& push_nest(line_t&& line, std::shared_ptr<line_node_t> parent) {
-		children_.emplace_back(std::make_shared<line_node_t>(line, parent));
+		children_.emplace_back(std::allocate_shared<line_node_t>(children_.get_allocator(), line, parent, children_.get_allocator().resource()));
 		return children_.back();
 	}
 	///	@brief	Gets the children of the node.
@@ -230,8 +294,54 @@ public:
 	/// @arg	true		Node is folding.
 	/// @arg	false		Node is not folding.
 	void set_folding(bool on) noexcept { folding_ = on; }
+	///	@brief	Gets the children of the node to modify them.
+	///	@return		the children of the node.
+	auto const& mutable_children() noexcept { return children_; }
 	///	@brief	Clears all the children.
 	void clear_children() noexcept { children_.clear(); }
+	///	@brief	Gets the identifier of the fragment.
+	///	@return		Identifier of the fragment. Zero means that the node is not a fragment to cache.
+	std::uint64_t fragment() const noexcept { return fragment_; }
+	///	@brief	Gets names of the variables that the fragment reads.
+	///	@return		Names of the variables.
+	auto const& reads() const noexcept { return reads_; }
+	///	@brief	Gets names of the variables that the fragment may write.
+	///	@return		Names of the variables.
+	auto const& writes() const noexcept { return writes_; }
+	///	@brief	Sets the node as a fragment to cache.
+	///	@param[in]	id		Identifier of the fragment. It must be unique across all the templates.
+	///	@param[in]	reads	Names of the variables that the fragment reads.
+	///	@param[in]	writes	Names of the variables that the fragment may write.
+	void set_fragment(std::uint64_t id, std::vector<std::string_view> reads, std::vector<std::string_view> writes) {
+		fragment_ = id;
+		reads_	  = std::move(reads);
+		writes_	  = std::move(writes);
+	}
+	///	@brief	Gets the 'else if' and 'else' branches following the 'if' line.
+	///	@return		The branches in order.
+	auto const& branches() const noexcept { return branches_; }
+	///	@brief	Gets whether the node is a branch linked to the preceding 'if' line or not.
+	///	@return		It returns true if the node is either linked 'else if' or 'else'; otherwise, it returns false.
+	bool chained() const noexcept { return chained_; }
+	///	@brief	Sets the branches following the 'if' line, and marks them as chained.
+	///	@param[in]	branches	The 'else if' and 'else' branches in order.
+	void set_branches(std::vector<branch_t> branches) { branches_ = std::move(branches); }
+	///	@brief	Marks the node as a branch linked to the preceding 'if' line.
+	///	@param[in]	on		Whether the node is linked or not.
+	void set_chained(bool on = true) noexcept { chained_ = on; }
+	///	@brief	Gets the jump table of the 'case' line.
+	///	@return		The jump table. It is null if the 'when's are malformed.
+	auto const& cases() const noexcept { return cases_; }
+	///	@brief	Sets the jump table of the 'case' line.
+	///	@param[in]	cases	The jump table, or null if the 'when's are malformed.
+	void set_cases(std::optional<cases_t> cases) { cases_ = std::move(cases); }
+	///	@brief	Gets whether the children never modify the context while they are parsed.
+	///		Iterations of a loop of such children do not depend on each other.
+	///	@return		It returns true if the children are independent; otherwise, it returns false.
+	bool independent() const noexcept { return independent_; }
+	///	@brief	Sets whether the children never modify the context while they are parsed.
+	///	@param[in]	on		Whether the children are independent or not.
+	void set_independent(bool on) noexcept { independent_ = on; }
 	///	@brief	Gets the previous 'sister' line.
 	///		The 'sister' is a child of the same parent.
 	///	@return		The previous 'sister' line.
@@ -240,19 +350,57 @@ public:
 		return ! parent || parent->children().empty() ? nullptr : parent->children().back();
 	}
 	///	@brief	Constructor.
-	///	@param[in]	line	Line
-	///	@param[in]	parent	Parent of this node.
-	explicit line_node_t(line_t const& line, std::shared_ptr<line_node_t> parent) noexcept :
-		children_{}, parent_{parent}, line_{line}, folding_{} {}
+	///	@param[in]	line		Line
+	///	@param[in]	parent		Parent of this node.
+	///	@param[in]	resource	Memory resource of this node and its descendants.
+	explicit line_node_t(line_t const& line, std::shared_ptr<line_node_t> parent, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept :
+		children_{resource}, parent_{parent}, line_{line}, folding_{}, fragment_{}, reads_{}, writes_{}, branches_{}, chained_{}, cases_{}, independent_{} {}
 	///	@brief	Constructor.
 	line_node_t() noexcept :
-		children_{}, parent_{}, line_{}, folding_{} {}
+		children_{}, parent_{}, line_{}, folding_{}, fragment_{}, reads_{}, writes_{}, branches_{}, chained_{}, cases_{}, independent_{} {}
+	///	@brief	Destructor.
+	///		Descendants are released one by one, so that releasing a deep tree never overflows the stack.
+	~line_node_t() {
+		std::vector<std::shared_ptr<line_node_t>> nodes(std::make_move_iterator(children_.rbegin()), std::make_move_iterator(children_.rend()));
+		while (! nodes.empty()) {
+			auto node = std::move(nodes.back());
+			nodes.pop_back();
+			if (node.use_count() != 1) continue;	// Another owner releases it later.
+
+			node->branches_.clear();	// Following siblings are no longer owned by the branches.
+			node->cases_.reset();
+			std::move(node->children_.rbegin(), node->children_.rend(), std::back_inserter(nodes));
+			node->children_.clear();
+		}
+	}
+	line_node_t(line_node_t const&)			   = delete;
+	line_node_t& operator=(line_node_t const&) = delete;
+
+	///	@brief	Detaches the children from the @p first to the end.
+	///	@param[in]	first	Index of the first child to detach.
+	///	@return		The detached children. Their parent is still this node.
+	std::vector<std::shared_ptr<line_node_t>> detach_children(std::size_t first) {
+		auto const itr = children_.begin() + static_cast<std::ptrdiff_t>(std::min(first, children_.size()));
+		std::vector<std::shared_ptr<line_node_t>> out(std::make_move_iterator(itr), std::make_move_iterator(children_.end()));
+		children_.erase(itr, children_.end());
+		return out;
+	}
+	///	@brief	Attaches the children detached from this node again at the end.
+	///	@param[in]	children	Children detached by the detach_children().
+	void attach_children(std::span<std::shared_ptr<line_node_t> const> children) { children_.insert(children_.end(), children.begin(), children.end()); }
 
 private:
-	std::vector<std::shared_ptr<line_node_t>> children_;	///< @brief	Children of the node.
+	std::pmr::vector<std::shared_ptr<line_node_t>> children_;	///< @brief	Children of the node.
 	std::weak_ptr<line_node_t>				  parent_;		///< @brief	Parent of the node.
 	line_t									  line_;		///< @brief	Line of the node.
 	bool									  folding_;		///< @brief	Whether folding or not.
+	std::uint64_t							  fragment_;	///< @brief	Identifier of the fragment.
+	std::vector<std::string_view>			  reads_;		///< @brief	Variables that the fragment reads.
+	std::vector<std::string_view>			  writes_;		///< @brief	Variables that the fragment may write.
+	std::vector<branch_t>					  branches_;	///< @brief	Branches following the 'if' line.
+	bool									  chained_;		///< @brief	Whether the node is a linked branch or not.
+	std::optional<cases_t>					  cases_;		///< @brief	Jump table of the 'case' line.
+	bool									  independent_;	///< @brief	Whether the children never modify the context or not.
 };
 
 ///	@brief	Pops nested nodes to the @p nest or less level.
@@ -261,7 +409,8 @@ private:
 ///	@param[in]	nest	Nested level to pop.
 ///	@return		The popped node.
 inline std::shared_ptr<line_node_t> pop_nest(std::shared_ptr<line_node_t> node, nest_t nest) {
-	return ! node || node->nest() <= nest ? node : pop_nest(node->parent(), nest);
+	while (node && nest < node->nest()) node = node->parent();
+	return node;
 }
 
 ///	@brief	Dumps hierarchy of nodes to the output stream.
@@ -283,52 +432,175 @@ inline void dump_lines(std::ostream& os, std::shared_ptr<line_node_t const> node
 	}
 }
 
+///	@brief	Builds the jump table of the 'case' line.
+///		Labels falling through empty 'when's are resolved to the line to render,
+///		so that rendering looks up the table only once.
+///	@param[in,out]	node	The 'case' line.
+inline void link_cases(line_node_t& node) {
+	std::vector<std::pair<std::string_view, std::shared_ptr<line_node_t const>>> labels;
+	for (auto const& a: node.mutable_children()) {
+		if (auto const& s = a->line(); s == def::default_sv) {
+			labels.emplace_back(std::string_view{}, a);
+		} else if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::when_re) && to_str(s, m, 1) == to_str(s, m, 3)) {
+			labels.emplace_back(to_str(s, m, 2), a);
+		} else {
+			return node.set_cases(std::nullopt);	// It fails when the 'case' is rendered.
+		}
+	}
+
+	line_node_t::cases_t			   cases;
+	std::shared_ptr<line_node_t const> target;	  // The line that the previous label falls through to.
+	for (auto itr = labels.crbegin(); itr != labels.crend(); ++itr) {
+		if (auto const& ch = itr->second->children(); ! ch.empty()) {
+			auto const& s = ch.front()->line();
+			target		  = std::regex_match(s.cbegin(), s.cend(), def::break_re) ? nullptr : itr->second;
+		}
+		if (! cases.emplace(itr->first, target).second) {
+			return node.set_cases(std::nullopt);	// Each label appears only once.
+		}
+	}
+	node.set_cases(std::move(cases));
+}
+
+///	@brief	Links conditional chains of the @p children.
+///	@param[in,out]	children	Sibling lines.
+inline void link_chains(std::span<std::shared_ptr<line_node_t> const> children) {
+	for (auto itr = children.begin(); itr != children.end(); ++itr) {
+		if (auto const& s = (*itr)->line(); std::regex_match(s.cbegin(), s.cend(), def::case_re)) {
+			link_cases(**itr);
+			continue;
+		} else if (! std::regex_match(s.cbegin(), s.cend(), def::if_re)) {
+			continue;
+		}
+
+		std::vector<line_node_t::branch_t> branches;
+		bool							   else_ = false, malformed = false;
+		for (auto next = std::next(itr); next != children.end(); ++next) {
+			auto const& line = (*next)->line();
+			if (svmatch m; std::regex_match(line.cbegin(), line.cend(), m, def::elif_re)) {
+				malformed = malformed || else_;	   // The 'else' appears at only the end of the sequence.
+				branches.emplace_back(to_str(line, m, 1), *next);
+			} else if (std::regex_match(line.cbegin(), line.cend(), def::else_re)) {
+				malformed = malformed || else_;	   // The 'else' appears only once.
+				else_	  = true;
+				branches.emplace_back(std::nullopt, *next);
+			} else {
+				break;
+			}
+			(*next)->set_chained();
+		}
+		if (malformed) branches.assign(1u, line_node_t::branch_t{});	// It fails when the branches are evaluated.
+		(*itr)->set_branches(std::move(branches));
+	}
+}
+
+///	@brief	Links conditional chains of the descendants of the @p root.
+///		Each 'if' line gets the following 'else if' and 'else' lines as its branches,
+///		so that rendering neither scans siblings nor matches the branches again.
+///	@param[in,out]	root	The root line.
+inline void link_conditionals(line_node_t& root) {
+	for (std::vector<line_node_t*> nodes{&root}; ! nodes.empty();) {
+		auto const& children = nodes.back()->mutable_children();
+		nodes.pop_back();
+		std::ranges::transform(children, std::back_inserter(nodes), [](auto const& a) { return a.get(); });
+		link_chains(children);
+	}
+}
+
+///	@brief	Gets whether the @p s line may modify the context while it is parsed, except by its children.
+///		It is conservative: directives that may assign variables or blocks, or that load other pug files, modify it.
+///	@param[in]	s	Line of the pug.
+///	@return		It returns true if the line may modify the context; otherwise, it returns false.
+inline bool is_modifying(std::string_view s) {
+	// Most lines are elements, which are rejected before matching the regular expressions.
+	if (! s.starts_with('-') && ! s.starts_with("each") && ! s.starts_with("block") && ! s.starts_with("include") && ! s.starts_with("extends")) return false;
+	return std::ranges::any_of(std::initializer_list<std::regex const*>{&def::var_re, &def::const_re, &def::each_re, &def::block_re, &def::include_re, &def::extends_re}, [s](auto const* re) { return std::regex_match(s.cbegin(), s.cend(), *re); });
+}
+
+///	@brief	Marks whether the children of the @p node never modify the context while they are parsed.
+///		Children of folding lines are not parsed as lines, but children of raw blocks are.
+///	@param[in,out]	node	Node whose children are marked already.
+inline void mark_independent(line_node_t& node) {
+	node.set_independent(std::ranges::all_of(node.mutable_children(), [](auto const& a) {
+		auto const& s = a->line();
+		return s.starts_with(def::folding_sv) || (a->independent() && ! is_modifying(s));
+	}));
+}
+
+///	@brief	Marks whether the children of every node of the @p root never modify the context while they are parsed,
+///		so that rendering a loop never scans its body.
+///	@param[in,out]	root	The root line.
+inline void link_independence(line_node_t& root) {
+	std::vector<line_node_t*> nodes;	// Descendants in pre-order.
+	for (std::vector<line_node_t*> stack{&root}; ! stack.empty();) {
+		nodes.push_back(stack.back());
+		stack.pop_back();
+		std::ranges::transform(nodes.back()->mutable_children(), std::back_inserter(stack), [](auto const& a) { return a.get(); });
+	}
+	std::ranges::for_each(nodes | std::views::reverse, [](auto* a) { mark_independent(*a); });	  // Children are marked before their parents.
+}
+
+///	@brief	Locates the @p a line in the tree of nested lines.
+///	@param[in]	previous	The line appended previously, or the root at first.
+///	@param[in]	a			Line to append.
+///	@return		It returns the following:
+///		-#	The parent to append the line. It is null if the line is dropped.
+///		-#	The line to append.
+///	@warning	Keep original string available because nodes refer view of the string.
+inline std::pair<std::shared_ptr<line_node_t>, line_t> locate_line(std::shared_ptr<line_node_t> const& previous, line_t const& a) {
+	auto const parent = previous->parent() ? previous->parent() : previous;
+	if (a.second.starts_with(def::comment_sv)) {
+		return {parent, line_t{previous->nest(), a.second}};	// Comment is always in the current level.
+	} else if (a.second.starts_with(def::raw_comment_sv)) {
+		return {nullptr, a};	// Drops pug comment.
+	} else if (std::regex_match(a.second.cbegin(), a.second.cend(), def::empty_re)) {
+		return {nullptr, a};	// Drops empty line.
+	} else if (previous->nest() == a.first) {
+		return {parent, a};	   // This line is a sister of the previous line.
+	} else if (parent->nest() < a.first) {
+		// This line is either a grandchild or a child of the previous line.
+		return {a.first <= previous->nest() ? parent : previous, a};
+	}
+	auto const popped = pop_nest(previous, a.first);
+	if (popped->nest() < a.first) {
+		return {popped, a};	   // This line is a cousin of the previous line.
+	}
+	return {popped->parent() ? popped->parent() : popped, a};	 // This line is an aunt of the previous line.
+}
+
+///	@brief	Appends the @p a line to the tree of nested lines.
+///	@param[in]	previous	The line appended previously, or the root at first.
+///	@param[in]	a			Line to append.
+///	@return		The line appended, which is the @p previous of the next line. It is the @p previous if the line is dropped.
+///	@warning	Keep original string available because nodes refer view of the string.
+inline std::shared_ptr<line_node_t> push_line(std::shared_ptr<line_node_t> previous, line_t const& a) {
+	if (a.second.starts_with(def::folding_sv)) {
+		auto const parent = previous->parent() ? previous->parent() : previous;
+		if (parent == previous) {
+			throw ex::syntax_error(__func__ + std::to_string(__LINE__));	// Folding line never be the top.
+		}
+		parent->set_folding(true);	  // Parent is folding.
+	}
+	auto const [parent, line] = locate_line(previous, a);
+	return parent ? parent->push_nest(line, parent) : previous;
+}
+
 ///	@brief	Parses file context as pug.
 ///	@param[in]	pug		File context formed as pug.
-///	@param[in]	nest	Base of nested level. It is added to nested levels of parsed nodes.
+///	@param[in]	nest		Base of nested level. It is added to nested levels of parsed nodes.
+///	@param[in]	resource	Memory resource of the nodes.
 ///	@return		The root of parsed nodes.
 ///	@warning	Keep original string available because it returns view of the string.
-inline std::shared_ptr<line_node_t> parse_file(std::string_view pug, nest_t nest = 0u) {
-	auto	   root		 = std::make_shared<line_node_t>(line_t{nest, std::string_view{}}, nullptr);
+///	@warning	Keep the @p resource available while the nodes are alive.
+inline std::shared_ptr<line_node_t> parse_file(std::string_view pug, nest_t nest = 0u, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+	auto	   root		 = std::allocate_shared<line_node_t>(std::pmr::polymorphic_allocator<line_node_t>{resource}, line_t{nest, std::string_view{}}, nullptr, resource);
 	auto const raw_lines = split_lines(pug);
 	auto const lines	 = raw_lines | std::views::transform(&get_line_nest) | std::views::transform([nest](auto const& a) { return line_t{a.first + nest, a.second}; });
 
 	// Parses to tree of nested lines.
-	(void)std::accumulate(lines.begin(), lines.end(), root, [](auto&& previous, auto const& a) {
-		auto parent = previous->parent() ? previous->parent() : previous;
-		if (a.second.starts_with(def::folding_sv)) {
-			if (parent == previous) {
-				throw ex::syntax_error(__func__ + std::to_string(__LINE__));	// Folding line never be the top.
-			}
-			parent->set_folding(true);	  // Parent is folding.
-		}
-		if (a.second.starts_with(def::comment_sv)) {
-			line_t const line{previous->nest(), a.second};
-			previous = parent->push_nest(line, parent);	   // Comment is always in the current level.
-		} else if (a.second.starts_with(def::raw_comment_sv)) {
-			// There is nothing to do.								// Drops pug comment.
-		} else if (std::regex_match(a.second.cbegin(), a.second.cend(), def::empty_re)) {
-			// There is nothing to do.
-			// Drops empty line.
-		} else if (previous->nest() == a.first) {
-			previous = parent->push_nest(a, parent);	// This line is a sister of the previous line.
-		} else if (parent->nest() < a.first) {
-			if (a.first <= previous->nest()) {
-				previous = parent->push_nest(a, parent);	// This line is a grandchild of the previous line.
-			} else {
-				previous = previous->push_nest(a, previous);	// This line is a child of the previous line.
-			}
-		} else {
-			previous = pop_nest(previous, a.first);
-			if (previous->nest() < a.first) {
-				previous = previous->push_nest(a, previous);	// This line is a cousin of the previous line.
-			} else {
-				parent	 = previous->parent() ? previous->parent() : previous;
-				previous = parent->push_nest(a, parent);	// This line is an aunt of the previous line.
-			}
-		}
-		return previous;
-	});
+	(void)std::accumulate(lines.begin(), lines.end(), root, &push_line);
+	link_conditionals(*root);
+	link_independence(*root);
 	return root;
 }
 
@@ -345,10 +617,359 @@ inline bool is_folding(std::shared_ptr<line_node_t const> line, bool parent_only
 	return ! parent_only && line->folding();
 }
 
+///	@brief	Cache of rendered fragments.
+///		A fragment is a subtree of a compiled template, whose HTML depends only on the variables it reads.
+///		Its HTML is memoized by the identifier of the fragment and the values of the variables.
+///		The least recently used entries are evicted when the total size exceeds the capacity.
+///		It is thread-safe, so that it can be shared by several renderings at once.
+class fragment_cache_t {
+public:
+	///	@brief	Memoized rendering of a fragment.
+	struct entry_t {
+		std::string										 html;		///< @brief	Generated HTML.
+		std::vector<std::pair<std::size_t, std::string>> writes;	///< @brief	Written variables by index of the writes of the fragment.
+	};
+
+	///	@brief	Finds the entry of the @p key.
+	///	@param[in]	key		Key of the entry.
+	///	@return		The entry. It returns null if it is not cached.
+	std::shared_ptr<entry_t const> find(std::string const& key) {
+		std::lock_guard lock{mutex_};
+		auto const		itr = index_.find(key);
+		if (itr == index_.cend()) {
+			++misses_;
+			return nullptr;
+		}
+		lru_.splice(lru_.begin(), lru_, itr->second);	 // The most recently used.
+		++hits_;
+		return itr->second->second;
+	}
+	///	@brief	Inserts the entry of the @p key.
+	///	@param[in]	key		Key of the entry.
+	///	@param[in]	entry	Entry to insert.
+	void insert(std::string key, entry_t entry) {
+		auto const size = cost(key, entry);
+		if (capacity_ < size) return;	 // It is never cached.
+
+		std::lock_guard lock{mutex_};
+		if (index_.contains(key)) return;
+		lru_.emplace_front(std::move(key), std::make_shared<entry_t const>(std::move(entry)));
+		index_.emplace(lru_.front().first, lru_.begin());
+		for (size_ += size; capacity_ < size_;) {
+			auto const& last = lru_.back();
+			size_ -= cost(last.first, *last.second);
+			index_.erase(last.first);
+			lru_.pop_back();
+		}
+	}
+	///	@brief	Clears all the entries and counters.
+	void clear() {
+		std::lock_guard lock{mutex_};
+		index_.clear();
+		lru_.clear();
+		size_	= 0u;
+		hits_	= 0u;
+		misses_ = 0u;
+	}
+	///	@brief	Gets the count of the cache hits.
+	///	@return		The count of the cache hits.
+	std::size_t hits() const noexcept { return hits_; }
+	///	@brief	Gets the count of the cache misses.
+	///	@return		The count of the cache misses.
+	std::size_t misses() const noexcept { return misses_; }
+	///	@brief	Gets the ratio of the cache hits.
+	///	@return		The ratio of the cache hits from 0.0 to 1.0.
+	double hit_rate() const noexcept {
+		auto const h = hits(), n = h + misses();
+		return n == 0u ? 0.0 : static_cast<double>(h) / static_cast<double>(n);
+	}
+	///	@brief	Gets the total size of the entries.
+	///	@return		The total size of the entries in bytes.
+	std::size_t size() const {
+		std::lock_guard lock{mutex_};
+		return size_;
+	}
+	///	@brief	Gets the capacity.
+	///	@return		The capacity in bytes.
+	std::size_t capacity() const noexcept { return capacity_; }
+
+	///	@brief	Constructor.
+	///	@param[in]	capacity	Capacity of the total size of the entries in bytes.
+	explicit fragment_cache_t(std::size_t capacity) noexcept :
+		mutex_{}, lru_{}, index_{}, capacity_{capacity}, size_{}, hits_{}, misses_{} {}
+	fragment_cache_t(fragment_cache_t const&)			 = delete;
+	fragment_cache_t& operator=(fragment_cache_t const&) = delete;
+
+private:
+	using lru_t = std::list<std::pair<std::string, std::shared_ptr<entry_t const>>>;
+
+	///	@brief	Gets the size of the entry to count.
+	///	@param[in]	key		Key of the entry.
+	///	@param[in]	entry	Entry.
+	///	@return		Size in bytes.
+	static std::size_t cost(std::string const& key, entry_t const& entry) noexcept {
+		return std::accumulate(entry.writes.cbegin(), entry.writes.cend(), key.size() + entry.html.size(), [](auto n, auto const& a) { return n + a.second.size(); });
+	}
+
+	mutable std::mutex									 mutex_;	   ///< @brief	Mutex of the entries.
+	lru_t												 lru_;		   ///< @brief	Entries from the most recently used.
+	std::unordered_map<std::string_view, lru_t::iterator> index_;	   ///< @brief	Entries by key.
+	std::size_t											 capacity_;	   ///< @brief	Capacity in bytes.
+	std::size_t											 size_;		   ///< @brief	Total size of the entries in bytes.
+	std::atomic<std::size_t>							 hits_;		   ///< @brief	Count of the cache hits.
+	std::atomic<std::size_t>							 misses_;	   ///< @brief	Count of the cache misses.
+};
+
+///	@brief	Scatter-gather list of generated HTML.
+///		It is a sequence of views like iovec, which refer either the pug sources or owned chunks of dynamic HTML.
+///		Consecutive dynamic HTML is merged into an owned chunk, and so are views shorter than the def::min_view_size.
+///		Sources and other owners of strings that the views refer are kept alive by the list.
+class segments_t {
+public:
+	///	@brief	Appends a view without copying it.
+	///	@param[in]	view	View to append. Its string must be kept alive by the caller or by the keep().
+	void append(std::string_view view) {
+		if (view.size() < def::min_view_size) return copy(view);
+		views_.push_back(view);
+		size_ += view.size();
+		tail_ = false;
+	}
+	///	@brief	Appends a copy of the @p str.
+	///	@param[in]	str		String to append.
+	void copy(std::string_view str) {
+		if (str.empty()) return;
+		if (! tail_) {
+			owned_.emplace_back();
+			views_.emplace_back();
+			tail_ = true;
+		}
+		owned_.back() += str;
+		views_.back() = owned_.back();	  // Appending may reallocate the owned chunk.
+		size_ += str.size();
+		copied_ += str.size();
+	}
+	///	@brief	Keeps the @p source alive while the list is alive.
+	///	@param[in]	source	Source that views refer.
+	///	@return		The kept source.
+	std::string const& keep(std::shared_ptr<std::string const> source) {
+		auto const& kept = *source;
+		sources_.push_back(std::move(source));
+		return kept;
+	}
+	///	@brief	Keeps the @p owner alive while the list is alive.
+	///	@param[in]	owner	Owner of strings that views refer, such as nodes referring their own strings.
+	void keep(std::shared_ptr<void const> owner) { sources_.push_back(std::move(owner)); }
+	///	@brief	Gets the views.
+	///	@return		The views in order.
+	std::vector<std::string_view> const& views() const noexcept { return views_; }
+	///	@brief	Gets the total size.
+	///	@return		The total size in bytes.
+	std::size_t size() const noexcept { return size_; }
+	///	@brief	Gets the size copied into the owned chunks.
+	///	@return		The size copied in bytes. The rest is referred without copying.
+	std::size_t copied() const noexcept { return copied_; }
+	///	@brief	Copies the views into the @p buffer.
+	///	@param[in]	buffer	Buffer to copy into.
+	///	@param[in]	size	Size of the @p buffer.
+	///	@return		The size copied, which is less than the size() if the @p buffer is too small.
+	std::size_t copy_to(char* buffer, std::size_t size) const noexcept {
+		std::size_t n = 0u;
+		for (auto const& a: views_) {
+			auto const c = std::min(a.size(), size - n);
+			std::copy_n(a.data(), c, buffer + n);
+			if ((n += c) == size) break;
+		}
+		return n;
+	}
+	///	@brief	Concatenates the views.
+	///	@return		The whole HTML.
+	std::string str() const {
+		std::string out(size_, '\0');
+		(void)copy_to(out.data(), out.size());
+		return out;
+	}
+
+	///	@brief	Constructor.
+	segments_t() = default;
+	segments_t(segments_t&&) noexcept			 = default;
+	segments_t& operator=(segments_t&&) noexcept = default;
+	segments_t(segments_t const&)				 = delete;	  // Copied views would refer the original chunks.
+	segments_t& operator=(segments_t const&)	 = delete;
+
+private:
+	std::vector<std::string_view>				views_;		///< @brief	Views in order.
+	std::deque<std::string>						owned_;		///< @brief	Owned chunks. Their addresses are stable as they are appended.
+	std::vector<std::shared_ptr<void const>>	sources_;	///< @brief	Sources and owners of strings that the views refer.
+	std::size_t									size_{};	///< @brief	Total size in bytes.
+	std::size_t									copied_{};	///< @brief	Size copied into the owned chunks.
+	bool										tail_{};	///< @brief	Whether the last view is an owned chunk to append.
+};
+
+///	@brief	Resource limits of a rendering.
+///		Each of them is unlimited by default.
+struct limits_t {
+	std::optional<std::chrono::steady_clock::duration> timeout{};												///< @brief	Wall-clock time from the start.
+	std::size_t										   iterations{std::numeric_limits<std::size_t>::max()};		///< @brief	Total iterations of loops.
+	std::size_t										   include_depth{std::numeric_limits<std::size_t>::max()};	///< @brief	Depth of includes and extends.
+	std::size_t										   output_size{std::numeric_limits<std::size_t>::max()};	///< @brief	Total size of generated HTML in bytes.
+	std::size_t										   memory{std::numeric_limits<std::size_t>::max()};			///< @brief	Total size of generated HTML, loaded sources and assigned variables in bytes.
+};
+
+///	@brief	Governor of resources of a rendering.
+///		The rendering checks it cooperatively at every line and iteration,
+///		and it throws the ex::limit_error if any limit is exceeded or stop is requested.
+///		It is thread-safe, so that loops rendered in parallel share it.
+///		A governor is used for a single rendering because its deadline starts when it is constructed.
+class governor_t {
+public:
+	///	@brief	Checks the deadline and the stop request.
+	///	@throws		ex::limit_error		It throws the exception if the deadline has passed or stop has been requested.
+	void check() const {
+		if (token_.stop_requested()) throw ex::limit_error(ex::limit_error::kind_t::stopped, "stop requested");
+		if (deadline_ && *deadline_ < std::chrono::steady_clock::now()) throw ex::limit_error(ex::limit_error::kind_t::deadline, "deadline exceeded");
+	}
+	///	@brief	Counts iterations of a loop.
+	///	@param[in]	count	Count of iterations.
+	///	@throws		ex::limit_error		It throws the exception if a limit is exceeded.
+	void iterate(std::size_t count = 1u) {
+		if (limits_.iterations < (iterations_ += count)) throw ex::limit_error(ex::limit_error::kind_t::iterations, "too many iterations");
+		check();
+	}
+	///	@brief	Checks the depth of includes and extends.
+	///	@param[in]	depth	Depth of the included file.
+	///	@throws		ex::limit_error		It throws the exception if the limit is exceeded.
+	void include(std::size_t depth) const {
+		if (limits_.include_depth < depth) throw ex::limit_error(ex::limit_error::kind_t::include_depth, "too deep includes");
+	}
+	///	@brief	Counts generated HTML.
+	///	@param[in]	size	Size of generated HTML in bytes.
+	///	@throws		ex::limit_error		It throws the exception if a limit is exceeded.
+	void output(std::size_t size) {
+		if (limits_.output_size < (output_ += size)) throw ex::limit_error(ex::limit_error::kind_t::output_size, "too large output");
+		allocate(size);
+	}
+	///	@brief	Counts allocated memory.
+	///	@param[in]	size	Size of allocated memory in bytes.
+	///	@throws		ex::limit_error		It throws the exception if the limit is exceeded.
+	void allocate(std::size_t size) {
+		if (limits_.memory < (memory_ += size)) throw ex::limit_error(ex::limit_error::kind_t::memory, "too much memory");
+	}
+	///	@brief	Gets the total iterations of loops.
+	///	@return		The total iterations.
+	std::size_t iterations() const noexcept { return iterations_; }
+	///	@brief	Gets the total size of generated HTML.
+	///	@return		The total size in bytes.
+	std::size_t output_size() const noexcept { return output_; }
+	///	@brief	Gets the total size of allocated memory.
+	///	@return		The total size in bytes.
+	std::size_t memory() const noexcept { return memory_; }
+
+	///	@brief	Constructor.
+	///	@param[in]	limits	Resource limits.
+	///	@param[in]	token	Token to stop the rendering cooperatively.
+	explicit governor_t(limits_t const& limits, std::stop_token token = std::stop_token{}) :
+		limits_{limits}, token_{std::move(token)}, deadline_{}, iterations_{}, output_{}, memory_{} {
+		if (limits_.timeout) deadline_ = std::chrono::steady_clock::now() + *limits_.timeout;
+	}
+	governor_t(governor_t const&)			 = delete;
+	governor_t& operator=(governor_t const&) = delete;
+
+private:
+	limits_t											 limits_;		 ///< @brief	Resource limits.
+	std::stop_token										 token_;		 ///< @brief	Token to stop.
+	std::optional<std::chrono::steady_clock::time_point> deadline_;		 ///< @brief	Deadline. Null means no deadline.
+	std::atomic<std::size_t>							 iterations_;	 ///< @brief	Total iterations of loops.
+	std::atomic<std::size_t>							 output_;		 ///< @brief	Total size of generated HTML.
+	std::atomic<std::size_t>							 memory_;		 ///< @brief	Total size of allocated memory.
+};
+
+///	@brief	Loader of pug files included and extended.
+///		It is shared by loops rendered in parallel, so that its load() must be thread-safe.
+class loader_t {
+public:
+	///	@brief	Loads the pug file.
+	///	@param[in]	path	Path of the pug file resolved from the including one.
+	///	@return		Source of the file. Nodes and segments refer views of it while they are alive.
+	///	@throws		xxx::pug::ex::io_error		It throws the exception if the file is not loaded.
+	virtual std::shared_ptr<std::string const> load(std::filesystem::path const& path) const = 0;
+
+	///	@brief	Destructor.
+	virtual ~loader_t() = default;
+};
+
+///	@brief	Loader reading pug files from the filesystem.
+class file_loader_t : public loader_t {
+public:
+	///	@copydoc	loader_t::load()
+	std::shared_ptr<std::string const> load(std::filesystem::path const& path) const override {
+		return std::make_shared<std::string const>(load_file(path));
+	}
+};
+
+///	@brief	Loader of pug files in memory, such as templates embedded in the binary or fetched from a config store.
+///		It makes no system calls while rendering. Paths are compared lexically after they are normalized.
+class memory_loader_t : public loader_t {
+public:
+	///	@copydoc	loader_t::load()
+	std::shared_ptr<std::string const> load(std::filesystem::path const& path) const override {
+		if (auto const itr = files_.find(key(path)); itr != files_.cend()) return itr->second;
+		throw ex::io_error(path, std::make_error_code(std::errc::no_such_file_or_directory));
+	}
+	///	@brief	Adds a pug file.
+	///		It must not be called while rendering.
+	///	@param[in]	path	Path of the pug file.
+	///	@param[in]	pug		Source string formatted in pug.
+	void add(std::filesystem::path const& path, std::string pug) {
+		files_.insert_or_assign(key(path), std::make_shared<std::string const>(std::move(pug)));
+	}
+	///	@brief	Has the pug file or not.
+	///	@param[in]	path	Path of the pug file.
+	///	@return		It returns true if the file exists; otherwise, it returns false.
+	bool contains(std::filesystem::path const& path) const { return files_.contains(key(path)); }
+
+private:
+	///	@brief	Gets the key of the @p path.
+	///	@param[in]	path	Path of the pug file.
+	///	@return		The normalized path; e.g., './parts/../page.pug' is 'page.pug'.
+	static std::string key(std::filesystem::path const& path) { return path.lexically_normal().generic_string(); }
+
+	std::unordered_map<std::string, std::shared_ptr<std::string const>> files_;	   ///< @brief	Sources by their normalized paths.
+};
+
+///	@brief	Rendering options.
+struct options_t {
+	bool								compact{};		   ///< @brief	Whether it emits minimal whitespaces, without indents nor pretty new lines.
+	fragment_cache_t*					cache{};		   ///< @brief	Cache of fragments of compiled templates. Null disables it.
+	std::vector<std::filesystem::path>* dependencies{};	   ///< @brief	Files read by include and extends are appended to it. Null disables it.
+	governor_t*							governor{};		   ///< @brief	Governor of resources. Null means unlimited.
+	std::pmr::memory_resource*			resource{};		   ///< @brief	Memory resource of the rendering. Null means the default resource.
+	loader_t const*						loader{};		   ///< @brief	Loader of files read by include and extends. Null reads them from the filesystem.
+};
+
+///	@brief	Gets the memory resource of the rendering.
+///	@param[in]	options		Rendering options.
+///	@return		The memory resource of the @p options, or the default resource if it is null.
+inline std::pmr::memory_resource* get_resource(options_t const& options) noexcept {
+	return options.resource ? options.resource : std::pmr::get_default_resource();
+}
+
+///	@brief	Slots of the variables that a compiled template refers.
+///		Names of the variables are resolved to dense indices at compiling, so that a context keeps their values in an array.
+struct slots_t {
+	std::unordered_map<std::string_view, std::size_t> index;		///< @brief	Indices of the slots by names of the variables.
+	bool											  dynamic{};	///< @brief	Whether the template includes or extends files, whose variables may have no slots.
+};
+
 ///	@brief	Parsing context,
 class context_t {
 	///	@brief	Map of blocks.
-	using blocks_t = std::unordered_map<std::string_view, std::shared_ptr<line_node_t const>>;
+	using blocks_t = std::pmr::unordered_map<std::string_view, std::shared_ptr<line_node_t const>>;
+	///	@brief	Map of variables allocated from the memory resource.
+	using storage_t = std::pmr::unordered_map<std::string_view, std::pmr::string>;
+	///	@brief	Value of a slot. The first element tells whether the variable is set or not.
+	using slot_t = std::pair<bool, std::pmr::string>;
+	///	@brief	Sources of included pug files.
+	using sources_t = std::pmr::vector<std::shared_ptr<std::string const>>;
 public:
 	///	@brief	Map of blocks.
 	using variables_t = std::unordered_map<std::string_view, std::string>;
@@ -376,54 +997,192 @@ public:
 	// ------------------------------
 	// Variables.
 
-	///	@brief	Gets all the variables.
-	///	@return		All the variables in current context.
-	auto const& variables() const noexcept { return variables_; }
+	///	@brief	Finds the variable.
+	///		A variable having its slot is an indexed load. The others are looked up in the maps.
+	///	@param[in]	tag		Name of the variable.
+	///	@return		The variable. It is null if the variable does not exist.
+	std::optional<std::string_view> find_variable(std::string_view tag) const noexcept {
+		if (auto const i = slot(tag); i) {
+			auto const& [set, value] = values_[*i];
+			return set ? std::make_optional<std::string_view>(value) : std::nullopt;
+		} else if (auto const itr = variables_.find(tag); itr != variables_.cend()) {
+			return itr->second;
+		} else if (base_) {
+			if (auto const itr = base_->find(tag); itr != base_->cend()) return itr->second;
+		}
+		return std::nullopt;
+	}
 	///	@brief	Gets the variable.
 	///	@param[in]	tag		Name of the variable.
 	///	@return		The variable.
-	auto const& variable(std::string_view tag) const noexcept { return variables_.at(tag); }
+	std::string_view variable(std::string_view tag) const { return find_variable(tag).value(); }
 	///	@brief	Has the variable or not.
 	///	@param[in]	tag		Name of the variable.
 	///	@return		It returns true if the variable exists; otherwise, it returns false.
-	bool has_variable(std::string_view tag) const noexcept { return variables_.contains(tag); }
+	bool has_variable(std::string_view tag) const noexcept { return find_variable(tag).has_value(); }
 	///	@brief	Sets the variable.
 	///	@param[in]	tag		Name of the variable. Empty is invalid.
 	///	@param[in]	block	Line of the variable.
 	void set_variable(std::string_view tag, std::string_view variable) {
 		if (tag.empty()) throw std::invalid_argument(__func__);
-		variables_[tag] = variable;
+		if (auto const i = slot(tag); i) {
+			values_[*i].first  = true;
+			values_[*i].second = variable;
+		} else {
+			variables_[tag] = variable;
+		}
+	}
+
+	// ------------------------------
+	// Options.
+
+	///	@brief	Gets the rendering options.
+	///	@return		The rendering options.
+	auto const& options() const noexcept { return options_; }
+	///	@brief	Counts the @p size of generated HTML by the governor if any.
+	///	@param[in]	size	Size of generated HTML in bytes.
+	void output(std::size_t size) const {
+		if (options_.governor) options_.governor->output(size);
+	}
+
+	// ------------------------------
+	// Depth of includes.
+
+	///	@brief	Gets the depth of includes and extends.
+	///	@return		The depth. The top-level pug is zero.
+	std::size_t depth() const noexcept { return depth_; }
+	///	@brief	Sets the depth of includes and extends.
+	///	@param[in]	depth	The depth.
+	void set_depth(std::size_t depth) noexcept { depth_ = depth; }
+	///	@brief	Keeps the @p source of an included pug until the rendering ends if the context refers it.
+	///		Names of the blocks and the variables that the included pug defines are views of its source.
+	///		The sources are shared by copies of the context; loops including files are rendered serially.
+	///	@param[in]	source	Source of the included pug.
+	void keep(std::shared_ptr<std::string const> source) {
+		auto const refers = [s = std::string_view{*source}](std::string_view a) { return ! std::less<char const*>{}(a.data(), s.data()) && std::less<char const*>{}(a.data(), s.data() + s.size()); };
+		if (std::ranges::none_of(blocks_ | std::views::keys, refers) && std::ranges::none_of(variables_ | std::views::keys, refers)) return;
+		if (! sources_) sources_ = std::allocate_shared<sources_t>(std::pmr::polymorphic_allocator<sources_t>{resource()});
+		sources_->push_back(std::move(source));
 	}
+
+	// ------------------------------
+	// Memory resource.
+
+	///	@brief	Gets the memory resource of the rendering.
+	///	@return		The memory resource.
+	std::pmr::memory_resource* resource() const noexcept { return variables_.get_allocator().resource(); }
+
 	///	@brief	Constructor.
 	context_t() noexcept :
-		blocks_{}, variables_{} {}
+		blocks_{}, slots_{}, values_{}, variables_{}, base_{}, sources_{}, options_{} {}
 	///	@brief	Constructor.
+	///		The @p variables are bound to the @p slots. The others are copied only if they may be referred.
 	///	@param[in]	variables	Variables.
-	explicit context_t(variables_t const& variables) noexcept :
-		blocks_{}, variables_{variables} {}
+	///	@param[in]	options		Rendering options. Maps of the context are allocated from its memory resource.
+	///	@param[in]	slots		Slots of the variables that the template refers. It is null if they are unknown.
+	///	@warning	Keep the @p slots available while the context is alive.
+	explicit context_t(variables_t const& variables, options_t const& options = options_t{}, slots_t const* slots = nullptr) :
+		blocks_{get_resource(options)}, slots_{slots}, values_{get_resource(options)}, variables_{get_resource(options)}, base_{}, sources_{}, options_{options} {
+		auto unresolved = ! slots || slots->dynamic;	// Whether variables without slots may be referred or not.
+		if (slots) {
+			values_.resize(slots->index.size());
+			for (auto const& [name, i]: slots->index) {
+				if (auto const itr = variables.find(name); itr != variables.cend()) {
+					values_[i].first  = true;
+					values_[i].second = itr->second;
+					unresolved		  = unresolved || itr->second.find(def::var_sv) != std::string::npos;	 // Its value may refer others.
+				}
+			}
+		}
+		if (unresolved) {
+			auto base = std::allocate_shared<storage_t>(std::pmr::polymorphic_allocator<storage_t>{get_resource(options)});
+			std::ranges::for_each(variables, [&base, slots](auto const& a) {
+				if (! slots || ! slots->index.contains(a.first)) base->emplace(a.first, a.second);
+			});
+			base_ = std::move(base);
+		}
+	}
+	///	@brief	Copy constructor.
+	///		The copy is allocated from the same memory resource.
+	context_t(context_t const& other) :
+		blocks_{other.blocks_, other.blocks_.get_allocator()}, slots_{other.slots_}, values_{other.values_, other.values_.get_allocator()}, variables_{other.variables_, other.variables_.get_allocator()}, base_{other.base_}, sources_{other.sources_}, options_{other.options_}, depth_{other.depth_} {}
+	context_t(context_t&&) noexcept			   = default;
+	context_t& operator=(context_t const&)	   = default;
+	context_t& operator=(context_t&&) noexcept = default;
 
 private:
-	blocks_t	blocks_;	   ///< @brief	Blocks.
-	variables_t variables_;	   ///< @brief	Variables.
+	///	@brief	Gets the slot of the variable.
+	///	@param[in]	tag		Name of the variable.
+	///	@return		Index of the slot. It is null if the variable has no slot.
+	std::optional<std::size_t> slot(std::string_view tag) const noexcept {
+		if (! slots_) return std::nullopt;
+		auto const itr = slots_->index.find(tag);
+		return itr == slots_->index.cend() ? std::nullopt : std::make_optional(itr->second);
+	}
+
+	blocks_t						 blocks_;		///< @brief	Blocks.
+	slots_t const*					 slots_;		///< @brief	Slots of the variables. It is null if they are unknown.
+	std::pmr::vector<slot_t>		 values_;		///< @brief	Values of the variables by their slots.
+	storage_t						 variables_;	///< @brief	Variables set without slots.
+	std::shared_ptr<storage_t const> base_;			///< @brief	Variables given without slots, which are shared by copies. It is null if they are never referred.
+	std::shared_ptr<sources_t>		 sources_;		///< @brief	Sources of included pug files that names of the blocks and the variables refer.
+	options_t						 options_;		///< @brief	Rendering options.
+	std::size_t						 depth_{};		///< @brief	Depth of includes and extends.
 };
 
 ///	@brief	Replaces all the variables (#{xxx}) in the @p str.
+///		Variables in the replaced values are replaced as well, except the ones being replaced.
 ///	@param[in]	context	Context including variables.
 ///	@param[in]	str		Input string.
 ///	@return	Replaced string.
 inline std::string replace_variables(context_t const& context, std::string_view str) {
 	if (str.find(def::var_sv) == std::string_view::npos) return std::string{str};
 
-	// It is not effective.because this implementation will scan while of the string by variables-count times.
-	auto s = std::string{str};
-	std::ranges::for_each(context.variables(), [&s](auto const& a) {
-		s = std::regex_replace(s, std::regex{R"(#\{)" + std::string{a.first} + R"(\})"}, a.second);
-	});
-	return s;
+	// It scans the string once, and each reference is looked up once.
+	std::string													out;
+	std::vector<std::pair<std::string_view, std::string_view>> frames{{str, std::string_view{}}};	 // Rest of strings, and names of the variables being replaced by them.
+	while (! frames.empty()) {
+		auto&	   rest = frames.back().first;
+		auto const end	= rest.find('}', std::min(rest.find(def::var_sv), rest.size()));
+		if (end == std::string_view::npos) {
+			out += rest;
+			frames.pop_back();
+			continue;
+		}
+		auto const pos	 = rest.rfind(def::var_sv, end);	// The innermost reference.
+		auto const name	 = rest.substr(pos + def::var_sv.size(), end - pos - def::var_sv.size());
+		auto const token = rest.substr(pos, end + 1u - pos);
+		out += rest.substr(0u, pos);
+		rest.remove_prefix(end + 1u);
+		if (auto const value = context.find_variable(name); value && std::ranges::none_of(frames, [name](auto const& a) { return a.second == name; })) {
+			frames.emplace_back(*value, name);
+		} else {
+			out += token;
+		}
+	}
+	return out;
 }
 
 std::tuple<std::string, context_t> parse_line(context_t const&, std::shared_ptr<line_node_t const>, std::filesystem::path const&);
 
+///	@brief	Reads the pug file included or extended.
+///		It records the file as a dependency if the options of the @p context requires.
+///	@param[in]	context	Parsing context.
+///	@param[in]	path	Path of the file to read.
+///	@return		Context of the file. It is shared with the loader of the options if any.
+///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+///	@throws		xxx::pug::ex::limit_error	It throws the exception if includes are too deep.
+inline std::shared_ptr<std::string const> load_dependency(context_t const& context, std::filesystem::path const& path) {
+	auto* const governor = context.options().governor;
+	if (governor) governor->include(context.depth() + 1u);
+	auto source = context.options().loader ? context.options().loader->load(path) : std::make_shared<std::string const>(load_file(path));
+	if (governor) governor->allocate(source->size());
+	if (auto* const dependencies = context.options().dependencies; dependencies) {
+		dependencies->push_back(path);
+	}
+	return source;
+}
+
 ///	@brief	Parses a element from the @p line.
 ///		This implementation supports only the following order:
 ///			tag#id.class.class(attr,attr)
@@ -431,18 +1190,18 @@ std::tuple<std::string, context_t> parse_line(context_t const&, std::shared_ptr<
 ///		Only element can be nested by ': '.
 ///	@param[in]	s		Pug source.
 ///	@param[in]	line	Line of the pug.
-///	@param[in]	context	Parsing context.
+///	@param[in]	options	Rendering options.
 ///	@return		It returns the followings:
 ///		-#	Remaining string of the line.
 ///		-#	Output stream.
 ///		-#	Tag name to close later.
 ///	@warning	Keep original string available because it returns view of the string.
 inline std::tuple<std::string_view, std::string, std::string_view>
-parse_element(std::string_view s, std::shared_ptr<line_node_t const> line) {
+parse_element(std::string_view s, std::shared_ptr<line_node_t const> line, options_t const& options = options_t{}) {
 	if (! line) throw std::invalid_argument(__func__);
 
 	if (s.empty() && line->parent()) {
-		return {std::string_view{}, "\n", std::string_view{}};
+		return {std::string_view{}, options.compact ? "" : "\n", std::string_view{}};
 	} else if (s == def::raw_html_sv) {
 		auto const& children = line->children();
 		return {std::string_view{}, std::accumulate(std::ranges::cbegin(children), std::ranges::cend(children), std::ostringstream{}, [](auto&& os, auto const& a) {
@@ -453,14 +1212,17 @@ parse_element(std::string_view s, std::shared_ptr<line_node_t const> line) {
 	} else if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::doctype_re)) {
 		// This implementation allows it is nested by the ': ' sequence.
 		std::ostringstream os;
-		os << "<!DOCTYPE " << to_str(s, m, 1) << ">" << '\n';
+		os << "<!DOCTYPE " << to_str(s, m, 1) << ">";
+		if (! options.compact) {
+			os << '\n';
+		}
 		return {std::string_view{}, os.str(), std::string_view{}};
 	} else if (std::regex_search(s.cbegin(), s.cend(), m, def::tag_re)) {
 		// Tag
 		auto			   tag		= to_str(s, m, 1);
 		auto const		   void_tag = def::void_tags.contains(tag);
 		std::ostringstream os;
-		if (! is_folding(line, true)) {
+		if (! options.compact && ! is_folding(line, true)) {
 			os << line->tabs();
 		}
 		os << "<";
@@ -476,7 +1238,7 @@ parse_element(std::string_view s, std::shared_ptr<line_node_t const> line) {
 		if (s.empty() || s.starts_with(": ")) {
 			s = s.empty() ? std::string_view{} : s.substr(2);
 			os << (void_tag ? " />" : ">");
-			os << (is_folding(line) ? "" : "\n");
+			os << (options.compact || is_folding(line) ? "" : "\n");
 			return {s, os.str(), void_tag ? std::string_view{} : tag};
 		} else if (s.starts_with("!=")) {
 			s = s.substr(2);
@@ -531,7 +1293,7 @@ parse_element(std::string_view s, std::shared_ptr<line_node_t const> line) {
 			} else {
 				os << c;
 			}
-			if (! is_folding(line)) {
+			if (! options.compact && ! is_folding(line)) {
 				os << '\n';
 			}
 			return {std::string_view{}, os.str(), void_tag ? std::string_view{} : tag};
@@ -541,7 +1303,93 @@ parse_element(std::string_view s, std::shared_ptr<line_node_t const> line) {
 	}
 }
 
+///	@brief	Opens elements of the @p line.
+///	@param[in]	context	Parsing context.
+///	@param[in]	line	Line of the pug.
+///	@return		It returns the followings:
+///		-#	Generated HTML string
+///		-#	Tag names to close later.
+///	@warning	Keep original string available because it returns view of the string.
+inline std::tuple<std::string, std::stack<std::string_view>> open_elements(context_t const& context, std::shared_ptr<line_node_t const> line) {
+	std::ostringstream			 oss;
+	std::stack<std::string_view> tags;
+	for (auto result = std::make_tuple(line->line(), std::string{}, std::string_view{}); ! std::get<0>(result).empty();) {
+		result = parse_element(std::get<0>(result), line, context.options());
+		if (auto const& tag = std::get<2>(result); ! tag.empty()) {
+			tags.push(tag);
+		}
+		oss << replace_variables(context, std::get<1>(result));
+	}
+	auto out = oss.str();
+	context.output(out.size());
+	return {std::move(out), std::move(tags)};
+}
+
+///	@brief	Closes elements of the @p line.
+///	@param[in]	context	Parsing context.
+///	@param[in]	line	Line of the pug.
+///	@param[in]	tags	Tag names to close.
+///	@return		Generated HTML string
+inline std::string close_elements(context_t const& context, std::shared_ptr<line_node_t const> line, std::stack<std::string_view> tags) {
+	std::ostringstream oss;
+	if (context.options().compact) {
+		for (; ! tags.empty(); tags.pop()) {
+			oss << "</" << tags.top() << ">";
+		}
+		context.output(static_cast<std::size_t>(oss.tellp()));
+		return oss.str();
+	}
+	for (auto const folding = is_folding(line); ! tags.empty(); tags.pop()) {
+		if (! folding) {
+			oss << line->tabs();
+		}
+		oss << "</" << tags.top() << ">";
+		if (! folding) {
+			oss << '\n';
+		}
+	}
+	if (line->folding()) {
+		oss << '\n';
+	}
+	context.output(static_cast<std::size_t>(oss.tellp()));
+	return oss.str();
+}
+
+///	@brief	Gets whether the line is a directive or not.
+///		Lines that are not directives are elements.
+///	@param[in]	s	Line of the pug.
+///	@return		It returns true if the line is a directive; otherwise, it returns false.
+inline bool is_directive(std::string_view s) {
+	if (s.starts_with(def::folding_sv)) return true;
+	// Most lines are elements, which are rejected before matching the regular expressions that allocate from the heap.
+	if (std::ranges::none_of(def::directive_prefixes, [s](auto const& a) { return s.starts_with(a); })) return false;
+	for (auto const* re: {&def::comment_re, &def::include_re, &def::extends_re, &def::block_re, &def::if_re, &def::elif_re, &def::else_re, &def::case_re, &def::for_re, &def::each_re, &def::var_re, &def::const_re}) {
+		if (std::regex_match(s.cbegin(), s.cend(), *re)) return true;
+	}
+	return false;
+}
+
+///	@brief	Frame of the explicit stack to render nested elements.
+struct frame_t {
+	std::shared_ptr<line_node_t const>				line;		///< @brief	Line of the element to close. It is null if nothing to close.
+	std::vector<std::shared_ptr<line_node_t const>> children;	///< @brief	Lines to render.
+	std::size_t										next;		///< @brief	Index of the next line to render.
+	std::stack<std::string_view>					tags;		///< @brief	Tag names to close.
+	std::shared_ptr<std::string const>				source;		///< @brief	Source of the included pug. It is null if not included.
+};
+
+///	@brief	Gets whether the @p line is rendered as an element by the explicit stack or not.
+///		Directives and fragments to cache are rendered by the parse_line() instead.
+///	@param[in]	context	Parsing context.
+///	@param[in]	line	Line of the pug.
+///	@return		It returns true if the @p line is an element; otherwise, it returns false.
+inline bool is_element(context_t const& context, line_node_t const& line) {
+	return ! is_directive(line.line()) && ! (context.options().cache && line.fragment());
+}
+
 ///	@brief	Parses children of the @p line.
+///		Nested elements are rendered with the explicit stack instead of recursion,
+///		so that a deep document never overflows the native stack.
 ///	@param[in]	context		Parsing context. It is not constant reference but copied.
 ///	@param[in]	children	Lines of children.
 ///	@param[in]	path		Path of the pug.
@@ -549,13 +1397,25 @@ parse_element(std::string_view s, std::shared_ptr<line_node_t const> line) {
 ///		-#	Generated HTML string
 ///		-#	Context.
 inline std::tuple<std::string, context_t> parse_children(context_t context, std::vector<std::shared_ptr<line_node_t const>> const& children, std::filesystem::path const& path) {
-	return {std::accumulate(std::ranges::cbegin(children), std::ranges::cend(children), std::ostringstream{}, [&context, &path](auto&& os, auto const& a) {
-				auto const [s, c] = parse_line(context, a, path);
-				context			  = c;
-				os << s;
-				return std::move(os);
-			}).str(),
-			context};
+	std::ostringstream		  oss;
+	std::pmr::vector<frame_t> frames{context.resource()};
+	frames.push_back({nullptr, children, 0u, {}, nullptr});
+	while (! frames.empty()) {
+		if (auto& frame = frames.back(); frame.next == frame.children.size()) {
+			if (frame.line) oss << close_elements(context, frame.line, std::move(frame.tags));
+			frames.pop_back();
+		} else if (auto const line = frame.children[frame.next++]; line && is_element(context, *line)) {
+			if (auto* const governor = context.options().governor; governor) governor->check();
+			auto [open, tags] = open_elements(context, line);
+			oss << open;
+			frames.push_back({line, line->children(), 0u, std::move(tags), nullptr});
+		} else {
+			auto [out, c] = parse_line(context, line, path);
+			context		  = std::move(c);
+			oss << out;
+		}
+	}
+	return {oss.str(), context};
 }
 
 namespace eval {
@@ -575,12 +1435,12 @@ struct operand_to_str {
 ///		- If the @p str is integer, it returns its value of long long integer.
 ///		- If the @p str is string, it returns a view of its string.
 ///		- If the @p is variable, it returns the value as integer, boolean, or string view.
-///	@param[in]	context	Context.
 ///	@param[in]	str		String.
+///	@param[in]	value	Value of the variable named the @p str. Null means that it is not a variable.
 ///	@return		Operand value.
-inline operand_t to_operand(context_t const& context, std::string_view str) {
-	auto const variable = context.has_variable(str);
-	auto const operand	= variable ? context.variable(str) : str;
+inline operand_t to_operand(std::string_view str, std::optional<std::string_view> value) {
+	auto const variable = value.has_value();
+	auto const operand	= value.value_or(str);
 
 	if (operand == "true")
 		return true;
@@ -598,7 +1458,15 @@ inline operand_t to_operand(context_t const& context, std::string_view str) {
 		return operand;
 	}
 	throw ex::syntax_error(__func__ + std::to_string(__LINE__) + std::string{str});
-};
+}
+
+///	@brief	Gets an operand value of the @p str in the @p context.
+///	@param[in]	context	Context.
+///	@param[in]	str		String.
+///	@return		Operand value.
+inline operand_t to_operand(context_t const& context, std::string_view str) {
+	return to_operand(str, context.find_variable(str));
+}
 
 ///	@brief	Assigns value to variable.
 /// @param[in]	context		Context.
@@ -738,7 +1606,155 @@ inline std::tuple<bool, context_t> evaluate(context_t const& context, std::strin
 	throw ex::syntax_error(__func__ + std::to_string(__LINE__));
 }
 
+///	@brief	Whether the current thread is a worker of parallel rendering or not.
+///		Nested loops are rendered serially by workers to avoid oversubscription.
+inline thread_local bool in_parallel = false;
+
+///	@brief	Pool of workers for parallel rendering.
+///		Workers are started at the first use and kept until the exit, so that a render never creates threads.
+///		Jobs of concurrent renders are queued, and each of them is taken by a worker.
+class workers_t {
+public:
+	///	@brief	Gets the pool of the process.
+	///	@return		The pool, whose workers are as many as the hardware concurrency except the calling thread.
+	static workers_t& instance() {
+		static workers_t workers{std::max(1u, std::thread::hardware_concurrency()) - 1u};
+		return workers;
+	}
+	///	@brief	Gets the count of the workers.
+	///	@return		Count of the workers.
+	std::size_t size() const noexcept { return threads_.size(); }
+	///	@brief	Runs the @p work on the calling thread and on the @p count workers, and waits for all of them.
+	///	@param[in]	work	Work to run, which must not throw exceptions.
+	///	@param[in]	count	Count of the workers to run the @p work.
+	void run(std::function<void()> const& work, std::size_t count) {
+		struct done_t {
+			std::atomic<std::size_t> running;	  ///< @brief	Count of the jobs running.
+			std::binary_semaphore	 finished{0};	 ///< @brief	Semaphore released by the last job.
+		};
+		auto const done = std::make_shared<done_t>(count);	 // The last job releases it after the caller may return.
+		{
+			std::lock_guard lock{mutex_};
+			std::generate_n(std::back_inserter(jobs_), count, [&work, &done] {
+				return [&work, done] {
+					work();
+					if (done->running.fetch_sub(1u) == 1u) done->finished.release();
+				};
+			});
+		}
+		queued_.release(static_cast<std::ptrdiff_t>(count));
+		work();
+		if (0u < count) done->finished.acquire();
+	}
+
+	///	@brief	Constructor.
+	///	@param[in]	count	Count of the workers.
+	explicit workers_t(std::size_t count) :
+		mutex_{}, jobs_{}, queued_{0}, threads_{} {
+		threads_.reserve(count);
+		std::generate_n(std::back_inserter(threads_), count, [this] { return std::jthread{[this] { serve(); }}; });
+	}
+	///	@brief	Destructor.
+	///		Workers find no jobs, and they are joined.
+	~workers_t() { queued_.release(static_cast<std::ptrdiff_t>(threads_.size())); }
+	workers_t(workers_t const&)			   = delete;
+	workers_t& operator=(workers_t const&) = delete;
+
+private:
+	///	@brief	Runs the jobs as a worker until it finds no jobs.
+	void serve() {
+		in_parallel = true;	   // Loops nested in the jobs are rendered serially.
+		for (;;) {
+			queued_.acquire();
+			std::unique_lock lock{mutex_};
+			if (jobs_.empty()) break;	 // It is released to stop.
+			auto const job = std::move(jobs_.front());
+			jobs_.pop_front();
+			lock.unlock();
+			job();
+		}
+	}
+
+	std::mutex						  mutex_;	   ///< @brief	Mutex of the jobs.
+	std::deque<std::function<void()>> jobs_;	   ///< @brief	Queued jobs.
+	std::counting_semaphore<>		  queued_;	   ///< @brief	Count of the queued jobs and the requests to stop.
+	std::vector<std::jthread>		  threads_;	   ///< @brief	Workers, which are joined before the other members are destroyed.
+};
+
+///	@brief	Renders the iterations in parallel and concatenates their outputs in order.
+///		Workers of the pool take chunks of iterations from the shared counter,
+///		so that fast workers take over the remaining chunks of slow ones.
+///		If any iterations threw, it rethrows the exception of the first iteration like serial rendering.
+///	@tparam		F		Type of the @p render.
+///	@param[in]	count	Count of the iterations.
+///	@param[in]	render	Function to render an iteration by its index.
+///	@return		Concatenated outputs of the iterations.
+template<typename F>
+inline std::string render_parallel(std::size_t count, F const& render) {
+	auto&	   pool	   = workers_t::instance();
+	auto const workers = std::min<std::size_t>(pool.size() + 1u, count);
+	auto const chunk   = std::max<std::size_t>(1u, count / (workers * def::parallel_chunks_per_worker));
+
+	std::vector<std::string>		outs(count);
+	std::vector<std::exception_ptr> errors(count);
+	std::atomic<std::size_t>		next{0u};
+	auto const						work = [&] {
+		   for (auto begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+			   for (auto i = begin, end = std::min(begin + chunk, count); i < end; ++i) {
+				   try {
+					   outs[i] = render(i);
+				   } catch (...) {
+					   errors[i] = std::current_exception();
+				   }
+			   }
+		   }
+	};
+	in_parallel = true;	   // Loops nested in the iterations are rendered serially.
+	pool.run(work, workers - 1u);
+	in_parallel = false;
+
+	if (auto const error = std::ranges::find_if(errors, [](auto const& a) { return static_cast<bool>(a); }); error != std::ranges::cend(errors)) {
+		std::rethrow_exception(*error);
+	}
+	std::string out;
+	out.reserve(std::accumulate(std::ranges::cbegin(outs), std::ranges::cend(outs), std::size_t{}, [](auto n, auto const& a) { return n + a.size(); }));
+	std::ranges::for_each(outs, [&out](auto const& a) { out += a; });
+	return out;
+}
+
+///	@brief	Gets whether the loop of the @p count iterations should be rendered in parallel or not.
+///	@param[in]	context	Parsing context.
+///	@param[in]	count	Count of the iterations.
+///	@return		It returns true if it should be rendered in parallel; otherwise, it returns false.
+inline bool is_parallel(context_t const& context, std::size_t count) noexcept {
+	// A memory resource, such as the std::pmr::monotonic_buffer_resource, may not be thread-safe.
+	return ! in_parallel && ! context.options().resource && def::parallel_min_iterations <= count && 0u < workers_t::instance().size();
+}
+
+///	@brief	Gets the key of the fragment to cache.
+///	@param[in]	context		Parsing context.
+///	@param[in]	line		Line of the fragment.
+///	@return		Key of the fragment. It returns null if the fragment cannot be cached with the context;
+///				e.g., a variable it reads has another variable to replace.
+inline std::optional<std::string> get_fragment_key(context_t const& context, line_node_t const& line) {
+	auto key = std::to_string(line.fragment()) + (context.options().compact ? 'c' : 'p');
+	for (auto const& name: line.reads()) {
+		if (! context.has_variable(name)) {
+			key += '-';
+			continue;
+		}
+		auto const& value = context.variable(name);
+		if (value.find(def::var_sv) != std::string::npos) return std::nullopt;
+		key += std::to_string(value.size()) + ':';
+		key += value;
+	}
+	return key;
+}
+
+std::tuple<std::string, context_t> parse_line_uncached(context_t const&, std::shared_ptr<line_node_t const>, std::filesystem::path const&);
+
 ///	@brief	Parses a line of pug.
+///		If the line is a fragment of a compiled template, its HTML is memoized by the cache of the options.
 ///	@param[in]	context	Parsing context.
 ///	@param[in]	line	Line of the pug.
 ///	@param[in]	path	Path of the pug.
@@ -746,25 +1762,81 @@ inline std::tuple<bool, context_t> evaluate(context_t const& context, std::strin
 ///		-#	Generated HTML string
 ///		-#	Context.
 inline std::tuple<std::string, context_t> parse_line(context_t const& context, std::shared_ptr<line_node_t const> line, std::filesystem::path const& path) {
-	if (! line) return {std::string{}, context};
+	if (auto* const governor = context.options().governor; governor) governor->check();
+	auto* const cache = context.options().cache;
+	if (! line || ! cache || ! line->fragment()) return parse_line_uncached(context, line, path);
 
-	if (auto const& s = line->line(); s.starts_with(def::folding_sv)) {
-		return {replace_variables(context, s.substr(2)), context};
-	} else if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::comment_re)) {
-		auto const out = line->tabs() + "<!-- " + replace_variables(context, to_str(s, m, 1)) + " -->" + '\n';
-		return {out, context};
-	} else if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::include_re)) {
-		// Opens an including pug file from relative path of the current pug.
-		auto const pug	  = std::filesystem::path{path}.replace_filename(to_str(s, m, 1));
-		auto const source = load_file(pug);	   // This string will be invalidated at the end of this function.
-		auto const sub	  = parse_file(source, line->nest());
-		return parse_line(context, sub, path);	  // Thus, output of the included pug must be finished here.
-	} else if (std::regex_match(s.cbegin(), s.cend(), m, def::extends_re)) {
-		// Opens an including pug file from relative path of the current pug.
-		auto const pug	  = std::filesystem::path{path}.replace_filename(to_str(s, m, 1));
-		auto const source = load_file(pug);	   // This string will be invalidated at the end of this function.
-		auto const sub	  = parse_file(source, line->nest());
-		return parse_line(context, sub, path);	  // Thus, output of the included pug must be finished here.
+	auto key = get_fragment_key(context, *line);
+	if (! key) return parse_line_uncached(context, line, path);
+	if (auto const entry = cache->find(*key); entry) {
+		context_t ctx = context;
+		std::ranges::for_each(entry->writes, [&ctx, &line](auto const& a) { ctx.set_variable(line->writes()[a.first], a.second); });
+		ctx.output(entry->html.size());
+		return {entry->html, ctx};
+	}
+
+	auto [out, ctx] = parse_line_uncached(context, line, path);
+	fragment_cache_t::entry_t entry{out, {}};
+	for (std::size_t i = 0u; i < line->writes().size(); ++i) {
+		if (auto const& name = line->writes()[i]; ctx.has_variable(name) && (! context.has_variable(name) || context.variable(name) != ctx.variable(name))) {
+			entry.writes.emplace_back(i, ctx.variable(name));
+		}
+	}
+	cache->insert(std::move(*key), std::move(entry));
+	return {std::move(out), std::move(ctx)};
+}
+
+///	@brief	Parses the pug included or extended by the @p context.
+///	@param[in]	context	Parsing context of the including pug.
+///	@param[in]	sub		The root of the included pug.
+///	@param[in]	path	Path of the pug.
+/// @return		It returns the following:
+///		-#	Generated HTML string
+///		-#	Context, whose depth is restored.
+inline std::tuple<std::string, context_t> parse_included(context_t const& context, std::shared_ptr<line_node_t const> sub, std::filesystem::path const& path) {
+	context_t ctx = context;
+	ctx.set_depth(context.depth() + 1u);
+	auto [out, c] = parse_line(ctx, sub, path);
+	c.set_depth(context.depth());
+	return {std::move(out), std::move(c)};
+}
+
+///	@brief	Parses a line of pug without the cache of fragments.
+///	@param[in]	context	Parsing context.
+///	@param[in]	line	Line of the pug.
+///	@param[in]	path	Path of the pug.
+/// @return		It returns the following:
+///		-#	Generated HTML string
+///		-#	Context.
+inline std::tuple<std::string, context_t> parse_line_uncached(context_t const& context, std::shared_ptr<line_node_t const> line, std::filesystem::path const& path) {
+	if (! line) return {std::string{}, context};
+	if (line->chained()) return {std::string{}, context};	 // It is rendered by the 'if' line.
+
+	if (auto const& s = line->line(); s.starts_with(def::folding_sv)) {
+		auto out = replace_variables(context, s.substr(2));
+		context.output(out.size());
+		return {std::move(out), context};
+	} else if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::comment_re)) {
+		auto const comment = "<!-- " + replace_variables(context, to_str(s, m, 1)) + " -->";
+		auto	   out	   = context.options().compact ? comment : line->tabs() + comment + '\n';
+		context.output(out.size());
+		return {std::move(out), context};
+	} else if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::include_re)) {
+		// Opens an including pug file from relative path of the current pug.
+		auto const pug	  = std::filesystem::path{path}.replace_filename(to_str(s, m, 1));
+		auto const source = load_dependency(context, pug);	  // Nodes of the included pug refer views of it.
+		auto const sub	  = parse_file(*source, line->nest(), context.resource());
+		auto [out, ctx]	  = parse_included(context, sub, path);
+		ctx.keep(source);	 // Blocks and variables it defines may refer the source after the nodes are released.
+		return {std::move(out), std::move(ctx)};
+	} else if (std::regex_match(s.cbegin(), s.cend(), m, def::extends_re)) {
+		// Opens an including pug file from relative path of the current pug.
+		auto const pug	  = std::filesystem::path{path}.replace_filename(to_str(s, m, 1));
+		auto const source = load_dependency(context, pug);	  // Nodes of the included pug refer views of it.
+		auto const sub	  = parse_file(*source, line->nest(), context.resource());
+		auto [out, ctx]	  = parse_included(context, sub, path);
+		ctx.keep(source);	 // Blocks and variables it defines may refer the source after the nodes are released.
+		return {std::move(out), std::move(ctx)};
 	} else if (std::regex_match(s.cbegin(), s.cend(), m, def::block_re)) {
 		if (auto const& tag = to_str(s, m, 1); context.has_block(tag)) {
 			// TODO: increases indent.
@@ -781,36 +1853,14 @@ inline std::tuple<std::string, context_t> parse_line(context_t const& context, s
 			return parse_children(context, line->children(), path);
 		}
 
-		// Collects else-if and elses.
-		std::vector<std::pair<std::string_view, std::shared_ptr<line_node_t const>>> elifs;
-		std::shared_ptr<line_node_t const>											 else_;
-		{
-			auto const parent = line->parent();
-			if (! parent) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
-			auto const& children = parent->children();
-			for (auto itr = ++std::ranges::find(children, line), end = std::ranges::cend(children); itr != end; ++itr) {
-				auto const& line = (*itr)->line();
-				if (svmatch m; std::regex_match(line.cbegin(), line.cend(), m, def::elif_re)) {
-					if (else_) throw ex::syntax_error(__func__ + std::to_string(__LINE__));	   // The 'else' appears at only the end of the sequence.
-					elifs.push_back({to_str(line, m, 1), *itr});
-				} else if (std::regex_match(line.cbegin(), line.cend(), m, def::else_re)) {
-					if (else_) throw ex::syntax_error(__func__ + std::to_string(__LINE__));	   // The 'else' appears only once.
-					else_ = *itr;
-				} else {
-					break;
-				}
-			}
-		}
-		for (auto const& elif: elifs) {
-			if (std::get<0>(evaluate(context, elif.first))) {
-				return parse_children(context, elif.second->children(), path);
+		// Else-ifs and else are linked by the parse_file().
+		for (auto const& [condition, branch]: line->branches()) {
+			if (! branch) throw ex::syntax_error(__func__ + std::to_string(__LINE__));	  // The 'else' appears only once at the end.
+			if (! condition || std::get<0>(evaluate(context, *condition))) {
+				return parse_children(context, branch->children(), path);
 			}
 		}
-		if (else_) {
-			return parse_children(context, else_->children(), path);
-		} else {
-			return {std::string{}, context};
-		}
+		return {std::string{}, context};
 	} else if (std::regex_match(s.cbegin(), s.cend(), m, def::elif_re)) {
 		// There is nothing to do because it is handled at if directive.
 		return {std::string{}, context};
@@ -820,47 +1870,14 @@ inline std::tuple<std::string, context_t> parse_line(context_t const& context, s
 	} else if (std::regex_match(s.cbegin(), s.cend(), m, def::case_re)) {
 		auto const ss  = to_str(s, m, 1);
 		auto const var = context.has_variable(ss) ? context.variable(ss) : ss;
-		// TODO:
-		using cases_t		= std::vector<std::pair<std::string_view, std::shared_ptr<line_node_t const>>>;
-		auto const contains = [](cases_t const& cases, std::string_view tag) {
-			return std::ranges::find_if(cases, [tag](auto const& a) { return a.first == tag; }) != std::ranges::cend(cases);
-		};
-		auto const& children	= line->children();
-		auto const	cases		= std::accumulate(std::ranges::cbegin(children), std::ranges::cend(children), cases_t{}, [contains](auto&& out, auto const& a) {
-			   if (auto const& ss = a->line(); ss == def::default_sv) {
-				   if (contains(out, std::string_view{})) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
-				   out.push_back({std::string_view{}, a});
-			   } else if (svmatch mm; std::regex_match(ss.cbegin(), ss.cend(), mm, def::when_re)) {
-				   if (to_str(ss, mm, 1) != to_str(ss, mm, 3)) {
-					   throw ex::syntax_error(__func__ + std::to_string(__LINE__));
-				   }
-				   auto const label = to_str(a->line(), mm, 2);
-				   if (contains(out, label)) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
-				   out.push_back({label, a});
-			   } else {
-				   throw ex::syntax_error(__func__ + std::to_string(__LINE__));
-			   }
-			   return std::move(out);
-		   });
-		auto const	parse_cases = [](context_t context, cases_t const& cases, std::string_view label, std::filesystem::path const& path) -> std::tuple<std::string, context_t> {
-			 for (auto itr = std::ranges::find_if(cases, [label](auto const& a) { return a.first == label; }); itr != std::ranges::cend(cases); ++itr) {
-				 auto const& children = itr->second->children();
-				 if (children.empty()) continue;
-				 auto const& line = children.front()->line();
-				 if (svmatch mm; std::regex_match(line.cbegin(), line.cend(), mm, def::break_re)) {
-					 break;
-				 }
-				 return parse_children(context, children, path);
-			 }
-			 return {std::string{}, context};
-		};
-		if (contains(cases, var)) {
-			return parse_cases(context, cases, var, path);
-		} else if (contains(cases, std::string_view{})) {
-			return parse_cases(context, cases, std::string_view{}, path);
-		} else {
-			return {std::string{}, context};
-		}
+
+		// The jump table is built by the parse_file().
+		auto const& cases = line->cases();
+		if (! cases) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+		auto itr = cases->find(var);
+		if (itr == cases->cend()) itr = cases->find(std::string_view{});
+		if (itr == cases->cend() || ! itr->second) return {std::string{}, context};
+		return parse_children(context, itr->second->children(), path);
 	} else if (std::regex_match(s.cbegin(), s.cend(), m, def::for_re)) {
 		auto const var		 = to_str(s, m, 1);
 		auto const initial	 = to_str(s, m, 2);
@@ -872,7 +1889,35 @@ inline std::tuple<std::string, context_t> parse_line(context_t const& context, s
 			context_t		ctx = context;
 			eval::operand_t v	= eval::to_operand(ctx, initial);	 // TODO: It supports a single literal only.
 			ctx.set_variable(var, std::visit(eval::operand_to_str{}, v));
+			if (svmatch mm; line->independent() && is_parallel(context, def::parallel_min_iterations) && std::regex_match(advance.cbegin(), advance.cend(), mm, def::binary_op_re) && to_str(advance, mm, 1) == var) {
+				// The body never modifies the context, so that only the advance changes the variable.
+				// Values are taken in batches, so that a long loop never holds all of them at once.
+				std::vector<std::string> values;
+				auto const				 render = [&context, var, &values, &line, &path](std::size_t i) {
+					  context_t c = context;
+					  c.set_variable(var, values[i]);
+					  return std::get<0>(parse_children(c, line->children(), path));
+				};
+				for (bool more = true; more;) {
+					values.clear();
+					while (values.size() < def::parallel_batch_iterations && (more = std::get<0>(evaluate(ctx, condition)))) {
+						if (auto* const governor = context.options().governor; governor) {
+							governor->iterate();
+							governor->allocate(ctx.variable(var).size());
+						}
+						values.emplace_back(ctx.variable(var));
+						ctx = std::get<1>(evaluate(ctx, advance));
+					}
+					if (is_parallel(context, values.size())) {
+						oss << render_parallel(values.size(), render);
+					} else {
+						std::ranges::for_each(std::views::iota(std::size_t{}, values.size()), [&oss, &render](auto i) { oss << render(i); });
+					}
+				}
+				return {oss.str(), context};
+			}
 			while (std::get<0>(evaluate(ctx, condition))) {	   // TODO: It supports simple binary comparison only.
+				if (auto* const governor = context.options().governor; governor) governor->iterate();
 				auto r		 = parse_children(ctx, line->children(), path);
 				auto [ss, c] = evaluate(std::get<1>(r), advance);	 // TODO:
 				oss << std::get<0>(r);
@@ -899,97 +1944,1445 @@ inline std::tuple<std::string, context_t> parse_line(context_t const& context, s
 			}
 		}
 
+		if (auto* const governor = context.options().governor; governor) {
+			governor->iterate(items.size());
+			governor->allocate(std::accumulate(items.cbegin(), items.cend(), std::size_t{}, [](auto n, auto const& a) { return n + a.size(); }));
+		}
 		if (items.empty()) {
 			return {std::string{}, context};
+		} else if (line->independent() && is_parallel(context, items.size())) {
+			// Every iteration starts from the same context, so that only the last one affects the following lines.
+			// Bodies loading other pug files are rendered serially to keep the order of the dependencies.
+			auto const render = [&context, name, &items, &line, &path](std::size_t i) {
+				context_t ctx = context;
+				ctx.set_variable(name, items[i]);
+				return parse_children(ctx, line->children(), path);
+			};
+			auto const out = render_parallel(items.size() - 1u, [&render](std::size_t i) { return std::get<0>(render(i)); });
+			auto [last, ctx] = render(items.size() - 1u);
+			return {out + last, ctx};
 		}
-		context_t  ctx	= context;
-		auto const outs = items | std::views::transform([&ctx, name, &line, &path](auto const& a) {
-							  ctx.set_variable(name, a);
-							  return parse_children(ctx, line->children(), path);
-						  });
-		return {std::accumulate(std::ranges::cbegin(outs), std::ranges::cend(outs), std::ostringstream{}, [](auto&& os, auto const& a) {
-					os << std::get<0>(a);
-					return std::move(os);
-				}).str(),
-				std::get<1>(outs.back())};
+		// Every iteration starts from the same context, so that only the last one affects the following lines.
+		context_t		   ctx = context, last = context;
+		std::ostringstream oss;
+		for (auto const& a: items) {
+			ctx.set_variable(name, a);
+			auto [out, c] = parse_children(ctx, line->children(), path);
+			oss << out;
+			last = std::move(c);
+		}
+		return {oss.str(), last};
 	} else if (std::regex_match(s.cbegin(), s.cend(), m, def::var_re) || std::regex_match(s.cbegin(), s.cend(), m, def::const_re)) {
 		auto const& name  = to_str(s, m, 1);
 		auto const& value = to_str(s, m, 2);
 		context_t	ctx	  = context;
+		if (auto* const governor = context.options().governor; governor) governor->allocate(value.size());
 		ctx.set_variable(name, (value.starts_with('"') || value.starts_with("'")) ? value.substr(1, value.size() - 2) : value);
 		return {std::string{}, ctx};
 	} else {
-		std::ostringstream			 oss;
-		std::stack<std::string_view> tags;
-		for (auto result = std::make_tuple(s, std::string{}, std::string_view{}); ! std::get<0>(result).empty();) {
-			result = parse_element(std::get<0>(result), line);
-			if (auto const& tag = std::get<2>(result); ! tag.empty()) {
-				tags.push(tag);
+		auto [open, tags]	 = open_elements(context, line);
+		auto const [ss, ctx] = parse_children(context, line->children(), path);
+		return {open + ss + close_elements(context, line, std::move(tags)), ctx};
+	}
+}
+
+///	@brief	Generator of a coroutine.
+///		It is an input range of the yielded values.
+///	@tparam		T	Type of the yielded values.
+template<typename T>
+class generator {
+public:
+	///	@brief	Promise of the coroutine.
+	struct promise_type {
+		std::optional<T>   value;	 ///< @brief	The last yielded value.
+		std::exception_ptr error;	 ///< @brief	Exception thrown by the coroutine.
+
+		generator			get_return_object() { return generator{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+		std::suspend_always initial_suspend() const noexcept { return {}; }
+		std::suspend_always final_suspend() const noexcept { return {}; }
+		std::suspend_always yield_value(T v) {
+			value = std::move(v);
+			return {};
+		}
+		void return_void() const noexcept {}
+		void unhandled_exception() noexcept { error = std::current_exception(); }
+	};
+
+	///	@brief	Iterator of the yielded values.
+	class iterator {
+	public:
+		using value_type	  = T;
+		using difference_type = std::ptrdiff_t;
+
+		T&		  operator*() const { return *handle_.promise().value; }
+		iterator& operator++() {
+			resume(handle_);
+			return *this;
+		}
+		void operator++(int) { ++*this; }
+		bool operator==(std::default_sentinel_t) const noexcept { return handle_.done(); }
+
+		///	@brief	Constructor.
+		///	@param[in]	handle	Handle of the coroutine.
+		explicit iterator(std::coroutine_handle<promise_type> handle) noexcept :
+			handle_{handle} {}
+
+	private:
+		std::coroutine_handle<promise_type> handle_;	///< @brief	Handle of the coroutine.
+	};
+
+	///	@brief	Starts the coroutine.
+	///	@return		Iterator at the first yielded value.
+	iterator begin() {
+		resume(handle_);
+		return iterator{handle_};
+	}
+	///	@brief	Gets the end of the yielded values.
+	///	@return		Sentinel.
+	std::default_sentinel_t end() const noexcept { return std::default_sentinel; }
+
+	///	@brief	Constructor.
+	///	@param[in]	handle	Handle of the coroutine.
+	explicit generator(std::coroutine_handle<promise_type> handle) noexcept :
+		handle_{handle} {}
+	generator(generator&& that) noexcept :
+		handle_{std::exchange(that.handle_, nullptr)} {}
+	generator& operator=(generator&& that) noexcept {
+		std::swap(handle_, that.handle_);
+		return *this;
+	}
+	///	@brief	Destructor.
+	~generator() {
+		if (handle_) handle_.destroy();
+	}
+	generator(generator const&)			   = delete;
+	generator& operator=(generator const&) = delete;
+
+private:
+	///	@brief	Resumes the coroutine and rethrows its exception.
+	///	@param[in]	handle	Handle of the coroutine.
+	static void resume(std::coroutine_handle<promise_type> handle) {
+		handle.resume();
+		if (auto const error = std::exchange(handle.promise().error, nullptr); error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	std::coroutine_handle<promise_type> handle_;	///< @brief	Handle of the coroutine.
+};
+
+///	@brief	Gets names of the variables that the @p line refers.
+///		It includes every token of expressions because an operand is a variable if it exists.
+///	@param[in]	s	Line of the pug.
+///	@return		Names of the variables.
+inline std::vector<std::string_view> get_references(std::string_view s) {
+	std::vector<std::string_view> names;
+	for (auto pos = s.find(def::var_sv); pos != std::string_view::npos; pos = s.find(def::var_sv, pos)) {
+		auto const end = s.find('}', pos);
+		if (end == std::string_view::npos) break;
+		names.push_back(s.substr(pos + def::var_sv.size(), end - pos - def::var_sv.size()));
+		pos = end;
+	}
+	if (s.starts_with('-') || std::ranges::any_of(std::initializer_list<std::regex const*>{&def::if_re, &def::elif_re, &def::case_re, &def::each_re}, [s](auto const* re) { return std::regex_match(s.cbegin(), s.cend(), *re); })) {
+		std::string_view rest = s;
+		for (auto pos = rest.find_first_not_of(" \t();"); pos != std::string_view::npos; pos = rest.find_first_not_of(" \t();")) {
+			rest			= rest.substr(pos);
+			auto const end	= rest.find_first_of(" \t();");
+			names.push_back(rest.substr(0, end));
+			rest = end == std::string_view::npos ? std::string_view{} : rest.substr(end);
+		}
+	}
+	return names;
+}
+
+///	@brief	Finds fragments of the subtree of the @p root to cache.
+///		A fragment is the largest subtree of elements that neither includes other files nor defines blocks.
+///		Subtrees are visited in post-order with the explicit stack instead of recursion.
+///	@param[in,out]	root	Node to find.
+///	@param[in,out]	id		The last identifier of fragments.
+///	@return		It returns names of the variables read and written by the subtree if it can be a part of fragment;
+///				otherwise, it returns null.
+inline std::optional<std::pair<std::set<std::string_view>, std::set<std::string_view>>> compile_fragments(line_node_t& root, std::atomic<std::uint64_t>& id) {
+	using names_t = std::pair<std::set<std::string_view>, std::set<std::string_view>>;	  // Names of the variables read and written.
+	struct finding_t {
+		line_node_t&												 node;		   ///< @brief	Node to find.
+		std::size_t													 next;		   ///< @brief	Index of the next child to find.
+		names_t														 names;		   ///< @brief	Names of the variables of the node.
+		std::vector<std::pair<std::shared_ptr<line_node_t>, names_t>> subs;		   ///< @brief	Children that can be a part of fragment.
+		bool														 cacheable;	   ///< @brief	Whether the node can be a part of fragment or not.
+		bool														 text;		   ///< @brief	Whether children of the node are text or not.
+	};
+	// It begins to find the @p node.
+	auto const begin = [](line_node_t& node) -> finding_t {
+		auto const& s = node.line();
+		if (s.starts_with(def::folding_sv)) {
+			// Children are not parsed as lines, but they are replaced.
+			// Children of the raw block are parsed as lines as well, so that they are found like children of elements.
+			std::set<std::string_view> reads;
+			std::ranges::for_each(node.mutable_children(), [&reads](auto const& a) { std::ranges::for_each(get_references(a->line()), [&reads](auto const& r) { reads.insert(r); }); });
+			std::ranges::for_each(get_references(s), [&reads](auto const& r) { reads.insert(r); });
+			return {node, node.mutable_children().size(), {std::move(reads), {}}, {}, true, true};
+		}
+		names_t names;
+		std::ranges::for_each(get_references(s), [&names](auto const& r) { names.first.insert(r); });
+		if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::var_re) || std::regex_match(s.cbegin(), s.cend(), m, def::const_re) || std::regex_match(s.cbegin(), s.cend(), m, def::each_re) || std::regex_match(s.cbegin(), s.cend(), m, def::for_re)) {
+			names.second.insert(to_str(s, m, 1));
+		}
+		bool const cacheable = std::ranges::none_of(std::initializer_list<std::regex const*>{&def::include_re, &def::extends_re, &def::block_re}, [s](auto const* re) { return std::regex_match(s.cbegin(), s.cend(), *re); });
+		return {node, 0u, std::move(names), {}, cacheable, false};
+	};
+	// It ends to find the node of the @p frame.
+	auto const end = [&id](finding_t& frame) -> std::optional<names_t> {
+		if (frame.text) {
+			return frame.cacheable ? std::make_optional(std::move(frame.names)) : std::nullopt;
+		}
+		if (frame.cacheable && frame.node.parent()) {
+			for (auto const& [child, sub]: frame.subs) {
+				frame.names.first.insert(sub.first.cbegin(), sub.first.cend());
+				frame.names.second.insert(sub.second.cbegin(), sub.second.cend());
 			}
-			oss << replace_variables(context, std::get<1>(result));
+			return std::move(frame.names);
 		}
+		// The largest subtrees of elements are fragments.
+		for (auto const& [child, sub]: frame.subs) {
+			if (! is_directive(child->line())) {
+				child->set_fragment(++id, std::vector<std::string_view>(sub.first.cbegin(), sub.first.cend()), std::vector<std::string_view>(sub.second.cbegin(), sub.second.cend()));
+			}
+		}
+		return std::nullopt;
+	};
 
-		auto const [ss, ctx] = parse_children(context, line->children(), path);
-		oss << ss;
+	std::vector<finding_t> frames;
+	frames.push_back(begin(root));
+	for (;;) {
+		if (auto& frame = frames.back(); frame.next < frame.node.mutable_children().size()) {
+			frames.push_back(begin(*frame.node.mutable_children()[frame.next++]));
+			continue;
+		}
+		auto sub = end(frames.back());
+		frames.pop_back();
+		if (frames.empty()) return sub;
 
-		for (; ! tags.empty(); tags.pop()) {
-			if (! is_folding(line)) {
-				oss << line->tabs();
+		auto& parent = frames.back();
+		if (auto const& child = parent.node.mutable_children()[parent.next - 1u]; sub) {
+			parent.subs.emplace_back(child, std::move(*sub));
+		} else {
+			parent.cacheable = false;
+		}
+	}
+}
+
+///	@brief	Memory resource counting the allocated bytes.
+class counting_resource_t : public std::pmr::memory_resource {
+public:
+	///	@brief	Gets the allocated bytes.
+	///	@return		The allocated bytes which are not deallocated yet.
+	std::size_t bytes() const noexcept { return bytes_; }
+
+	///	@brief	Constructor.
+	counting_resource_t() noexcept :
+		bytes_{} {}
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+		auto* const p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		bytes_ += bytes;
+		return p;
+	}
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+		bytes_ -= bytes;
+	}
+	bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+	std::atomic<std::size_t> bytes_;	///< @brief	Allocated bytes.
+};
+
+///	@brief	Interner of subtrees shared by compiled templates, which is hash-consing.
+///		Nodes are interned from the leaves, so that a subtree is identified by its line and the identities of its interned children.
+///		An interned node has its own strings, and it is immutable and shared by all the templates having the same subtree.
+///		Its parent is a placeholder which tells only whether the parent is folding or not, because its parents are many.
+///		It is thread-safe, so that templates can be compiled at once.
+class interner_t {
+public:
+	///	@brief	Interns the descendants of the @p root, and replaces the children of the @p root with the interned nodes.
+	///	@param[in,out]	root	The root of a compiled template.
+	void intern(line_node_t& root) {
+		std::vector<line_node_t*> nodes;	// Descendants in pre-order.
+		for (std::vector<line_node_t*> stack{&root}; ! stack.empty();) {
+			nodes.push_back(stack.back());
+			stack.pop_back();
+			std::ranges::transform(nodes.back()->mutable_children() | std::views::reverse, std::back_inserter(stack), [](auto const& a) { return a.get(); });
+		}
+
+		std::lock_guard													 lock{mutex_};
+		std::unordered_map<line_node_t const*, std::shared_ptr<line_node_t>> interned;	   // Interned nodes by the original ones.
+		for (auto* node: nodes | std::views::reverse) {	   // Children and following sisters, which are branches, are interned earlier.
+			std::vector<std::shared_ptr<line_node_t>> children;
+			std::ranges::transform(node->mutable_children(), std::back_inserter(children), [&interned](auto const& a) { return interned.at(a.get()); });
+			if (node == &root) {
+				(void)root.detach_children(0u);
+				root.attach_children(children);
+			} else {
+				std::vector<line_node_t::branch_t> branches;
+				std::ranges::transform(node->branches(), std::back_inserter(branches), [&interned](auto const& a) { return line_node_t::branch_t{a.first, a.second ? interned.at(a.second.get()) : nullptr}; });
+				interned.emplace(node, find(*node, children, branches));
 			}
-			oss << "</" << tags.top() << ">";
-			if (! is_folding(line)) {
-				oss << '\n';
+		}
+	}
+	///	@brief	Releases the interned nodes which no templates refer.
+	///	@return		Count of the released nodes.
+	std::size_t prune() {
+		std::lock_guard lock{mutex_};
+		std::size_t		pruned = 0u;
+		for (std::size_t n = 1u; n != 0u; pruned += n) {	// Releasing a node may release its children.
+			n = std::erase_if(table_, [](auto const& a) { return a.second.use_count() == 1; });
+		}
+		return pruned;
+	}
+
+	///	@brief	Gets the count of the interned nodes.
+	///	@return		The count of the nodes.
+	std::size_t count() const {
+		std::lock_guard lock{mutex_};
+		return table_.size();
+	}
+	///	@brief	Gets the resident bytes of the interned nodes.
+	///	@return		The resident bytes including their strings.
+	std::size_t size() const noexcept { return resource_.bytes(); }
+
+	///	@brief	Constructor.
+	interner_t() :
+		resource_{}, parents_{std::make_shared<line_node_t>(line_t{}, nullptr), std::make_shared<line_node_t>(line_t{}, nullptr)}, mutex_{}, table_{&resource_} {
+		parents_[1]->set_folding(true);
+	}
+	interner_t(interner_t const&)			 = delete;
+	interner_t& operator=(interner_t const&) = delete;
+
+private:
+	///	@brief	Interned node with its strings.
+	struct node_t {
+		std::pmr::string text;	  ///< @brief	The line and names of the variables of the fragment. The node refers views of it.
+		line_node_t		 node;	  ///< @brief	The node.
+
+		///	@brief	Constructor.
+		///	@param[in]	from		Node to copy the line.
+		///	@param[in]	parent		Placeholder of the parent.
+		///	@param[in]	resource	Memory resource of the node.
+		node_t(line_node_t const& from, std::shared_ptr<line_node_t> const& parent, std::pmr::memory_resource* resource) :
+			text{join(from, resource)}, node{line_t{from.nest(), std::string_view{text}.substr(0u, from.line().size())}, parent, resource} {}
+
+		///	@brief	Joins the line and names of the variables of the @p from.
+		///	@param[in]	from		Node to copy the line.
+		///	@param[in]	resource	Memory resource of the string.
+		///	@return		The joined string.
+		static std::pmr::string join(line_node_t const& from, std::pmr::memory_resource* resource) {
+			std::pmr::string s{from.line(), resource};
+			std::ranges::for_each(from.reads(), [&s](auto const& a) { s += a; });
+			std::ranges::for_each(from.writes(), [&s](auto const& a) { s += a; });
+			return s;
+		}
+	};
+
+	///	@brief	Finds the interned node identical to the @p node, or interns it.
+	///	@param[in]	node		Node to intern.
+	///	@param[in]	children	Interned children of the @p node.
+	///	@param[in]	branches	Branches of the @p node, whose lines are interned.
+	///	@return		The interned node.
+	std::shared_ptr<line_node_t> find(line_node_t const& node, std::vector<std::shared_ptr<line_node_t>> const& children, std::vector<line_node_t::branch_t> const& branches) {
+		auto const folded = node.parent() && node.parent()->folding();
+		auto	   hash	  = std::hash<std::string_view>{}(node.line());
+		auto const mix	  = [&hash](std::size_t h) { hash ^= h + 0x9e3779b97f4a7c15u + (hash << 6u) + (hash >> 2u); };
+		mix(node.nest());
+		mix((node.folding() ? 1u : 0u) | (node.chained() ? 2u : 0u) | (folded ? 4u : 0u) | (node.fragment() ? 8u : 0u));
+		std::ranges::for_each(node.reads(), [&mix](auto const& a) { mix(std::hash<std::string_view>{}(a)); });
+		std::ranges::for_each(node.writes(), [&mix](auto const& a) { mix(std::hash<std::string_view>{}(a)); });
+		std::ranges::for_each(children, [&mix](auto const& a) { mix(std::hash<void const*>{}(a.get())); });
+		std::ranges::for_each(branches, [&mix](auto const& a) { mix(std::hash<void const*>{}(a.second.get())); });
+
+		auto const [first, last] = table_.equal_range(hash);
+		for (auto itr = first; itr != last; ++itr) {
+			if (auto& a = itr->second->node; a.nest() == node.nest() && a.line() == node.line() && a.folding() == node.folding() && a.chained() == node.chained()
+											 && a.parent()->folding() == folded && (a.fragment() != 0u) == (node.fragment() != 0u) && std::ranges::equal(a.reads(), node.reads())
+											 && std::ranges::equal(a.writes(), node.writes()) && std::ranges::equal(a.mutable_children(), children) && std::ranges::equal(a.branches(), branches)) {
+				return std::shared_ptr<line_node_t>{itr->second, &a};
 			}
 		}
-		if (line->folding()) {
-			oss << '\n';
+
+		auto const interned = std::allocate_shared<node_t>(std::pmr::polymorphic_allocator<node_t>{&resource_}, node, parents_[folded ? 1u : 0u], &resource_);
+		auto&	   a		= interned->node;
+		a.set_folding(node.folding());
+		a.set_chained(node.chained());
+		a.set_independent(node.independent());
+		a.attach_children(children);
+		if (node.fragment()) {
+			std::string_view rest = std::string_view{interned->text}.substr(node.line().size());
+			auto const		 take = [&rest](auto const& s) {
+				  auto const v = rest.substr(0u, s.size());
+				  rest.remove_prefix(s.size());
+				  return v;
+			};
+			std::vector<std::string_view> reads, writes;
+			std::ranges::transform(node.reads(), std::back_inserter(reads), take);
+			std::ranges::transform(node.writes(), std::back_inserter(writes), take);
+			a.set_fragment(node.fragment(), std::move(reads), std::move(writes));
+		}
+		if (! branches.empty()) {
+			// Conditions refer the lines of the interned branches.
+			std::vector<line_node_t::branch_t> linked;
+			std::ranges::transform(node.branches(), branches, std::back_inserter(linked), [](auto const& from, auto const& to) {
+				return ! from.first || ! to.second ? to : line_node_t::branch_t{to.second->line().substr(static_cast<std::size_t>(from.first->data() - from.second->line().data()), from.first->size()), to.second};
+			});
+			a.set_branches(std::move(linked));
+		}
+		if (node.cases()) link_cases(a);
+		table_.emplace(hash, interned);
+		return std::shared_ptr<line_node_t>{interned, &a};
+	}
+
+	counting_resource_t													 resource_;	   ///< @brief	Memory resource of the interned nodes.
+	std::array<std::shared_ptr<line_node_t>, 2u>						 parents_;	   ///< @brief	Placeholders of the parents, which are not folding and folding.
+	mutable std::mutex													 mutex_;	   ///< @brief	Mutex of the table.
+	std::pmr::unordered_multimap<std::size_t, std::shared_ptr<node_t>> table_;	   ///< @brief	Interned nodes by their hashes.
+};
+
+///	@brief	The last identifier of fragments. Identifiers are unique across all the templates sharing a cache.
+inline std::atomic<std::uint64_t> last_fragment{0u};
+
+///	@brief	Resolves the variables that the tree of the @p root refers to slots.
+///		Indices are assigned in order of their first references.
+///	@param[in]	root	The root of the tree.
+///	@return		Slots of the variables.
+inline slots_t get_slots(line_node_t const& root) {
+	slots_t slots;
+	for (std::vector<line_node_t const*> nodes{&root}; ! nodes.empty();) {
+		auto const& node = *nodes.back();
+		auto const& s	 = node.line();
+		nodes.pop_back();
+		std::ranges::for_each(get_references(s), [&slots](auto const& a) { slots.index.emplace(a, slots.index.size()); });
+		if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::var_re) || std::regex_match(s.cbegin(), s.cend(), m, def::const_re) || std::regex_match(s.cbegin(), s.cend(), m, def::each_re) || std::regex_match(s.cbegin(), s.cend(), m, def::for_re)) {
+			slots.index.emplace(to_str(s, m, 1), slots.index.size());
+		} else if (std::regex_match(s.cbegin(), s.cend(), def::include_re) || std::regex_match(s.cbegin(), s.cend(), def::extends_re)) {
+			slots.dynamic = true;	 // Variables of the other files are looked up by their names.
+		}
+		auto const children = node.children();
+		std::ranges::for_each(children | std::views::reverse, [&nodes](auto const& a) { nodes.push_back(a.get()); });
+	}
+	return slots;
+}
+
+///	@brief	Compiles the pug string to the tree of lines with fragments to cache.
+///	@param[in]	pug			Source string formatted in pug.
+///	@param[in]	resource	Memory resource of the nodes.
+///	@param[in]	interner	Interner sharing identical subtrees with other templates. It is null not to share them.
+///	@return		The root of the tree.
+///	@warning	Keep original string available because nodes refer views of it.
+///	@warning	Keep the @p resource and the @p interner available while the nodes are alive.
+inline std::shared_ptr<line_node_t const> compile(std::string_view pug, std::pmr::memory_resource* resource = std::pmr::get_default_resource(), interner_t* interner = nullptr) {
+	auto const root = parse_file(pug, 0u, resource);
+	(void)compile_fragments(*root, last_fragment);
+	if (interner) interner->intern(*root);
+	return root;
+}
+
+///	@brief	Error found by validation.
+struct diagnostic_t {
+	std::filesystem::path path;		  ///< @brief	Path of the pug file.
+	std::size_t			  line{};	  ///< @brief	Line number from 1. Zero means the whole file.
+	std::string			  message;	  ///< @brief	Message to display.
+
+	auto operator<=>(diagnostic_t const&) const = default;
+};
+
+///	@brief	Gets the line number of the @p line in the @p source.
+///	@param[in]	source	Pug source.
+///	@param[in]	line	View of a line in the @p source.
+///	@return		Line number from 1.
+inline std::size_t get_line_number(std::string_view source, std::string_view line) noexcept {
+	auto const offset = std::clamp<std::ptrdiff_t>(line.data() - source.data(), 0, static_cast<std::ptrdiff_t>(source.size()));
+	return 1u + static_cast<std::size_t>(std::count(source.cbegin(), source.cbegin() + offset, '\n'));
+}
+
+///	@brief	Gets whether the @p str is an operand or not.
+///		A variable is unknown until rendering, so that a name is an operand.
+///	@param[in]	str		String.
+///	@return		It returns true if the @p str is either a literal or a name; otherwise, it returns false.
+inline bool is_operand(std::string_view str) {
+	if (std::regex_match(str.cbegin(), str.cend(), def::name_re)) return true;
+	try {
+		(void)eval::to_operand(str, std::nullopt);
+		return true;
+	} catch (ex::syntax_error const&) {
+		return false;
+	}
+}
+
+///	@brief	Validates the @p expression.
+///	@param[in]	expression	Expression.
+///	@param[in]	ops			Supported operators.
+///	@return		Message of the error. It returns null if the @p expression is valid.
+inline std::optional<std::string> check_expression(std::string_view expression, std::set<std::string_view> const& ops) {
+	svmatch m;
+	if (! std::regex_match(expression.cbegin(), expression.cend(), m, def::binary_op_re)) return "unsupported expression '" + std::string{expression} + "'";
+	if (! ops.contains(to_str(expression, m, 2))) return "unsupported operator '" + std::string{to_str(expression, m, 2)} + "'";
+	for (auto const n: {1u, 3u}) {
+		if (! is_operand(to_str(expression, m, n))) return "invalid operand '" + std::string{to_str(expression, m, n)} + "'";
+	}
+	return std::nullopt;
+}
+
+///	@brief	Validates a quoted or bare literal.
+///	@param[in]	str		Literal.
+///	@return		It returns true if quotes are balanced; otherwise, it returns false.
+inline bool is_quoted(std::string_view str) noexcept {
+	if (! str.starts_with('"') && ! str.starts_with('\'')) return true;
+	return 2u <= str.size() && str.front() == str.back();
+}
+
+void check_file(std::filesystem::path const&, std::filesystem::path const&, std::vector<std::filesystem::path>&, std::vector<diagnostic_t>&);
+
+///	@brief	Validates descendants of the @p node without rendering.
+///		It validates directives, expressions, elements and included files.
+///		Descendants are visited in pre-order with the explicit stack instead of recursion.
+///	@param[in]		node		Parent line.
+///	@param[in]		source		Pug source of the @p node.
+///	@param[in]		file		Path of the @p source to report.
+///	@param[in]		path		Path of the top-level pug, from which included files are resolved.
+///	@param[in,out]	chain		Files including the @p source, to find recursive includes.
+///	@param[in,out]	out			Errors found.
+inline void check_lines(std::shared_ptr<line_node_t const> node, std::string_view source, std::filesystem::path const& file, std::filesystem::path const& path, std::vector<std::filesystem::path>& chain, std::vector<diagnostic_t>& out) {
+	struct checking_t {
+		std::vector<std::shared_ptr<line_node_t const>> children;	 ///< @brief	Lines to validate.
+		std::size_t										next;		 ///< @brief	Index of the next line to validate.
+		std::optional<std::set<std::string_view>>		labels;		 ///< @brief	Labels of the 'case' if the lines are 'when's.
+	};
+	std::vector<checking_t> frames;
+	frames.push_back({node->children(), 0u, std::nullopt});
+	while (! frames.empty()) {
+		auto& frame = frames.back();
+		if (frame.next == frame.children.size()) {
+			frames.pop_back();
+			continue;
+		}
+		auto const	index  = frame.next++;
+		auto const	line   = frame.children[index];
+		auto const& s	   = line->line();
+		auto const	report = [&](std::string message) { out.push_back({file, get_line_number(source, s), std::move(message)}); };
+		// It gets whether the previous sibling is either 'if' or 'else if'.
+		auto const follows_if = [&frame, index] {
+			if (index == 0u) return false;
+			auto const& p = frame.children[index - 1u]->line();
+			return std::regex_match(p.cbegin(), p.cend(), def::if_re) || std::regex_match(p.cbegin(), p.cend(), def::elif_re);
+		};
+
+		if (auto& labels = frame.labels; labels) {
+			if (svmatch mm; s == def::default_sv) {
+				if (! labels->insert(std::string_view{}).second) report("duplicated 'default'");
+			} else if (! std::regex_match(s.cbegin(), s.cend(), mm, def::when_re) || to_str(s, mm, 1) != to_str(s, mm, 3)) {
+				report("invalid 'when'");
+				continue;
+			} else if (! labels->insert(to_str(s, mm, 2)).second) {
+				report("duplicated 'when'");
+			}
+			frames.push_back({line->children(), 0u, std::nullopt});
+			continue;
+		}
+
+		for (auto pos = s.find(def::var_sv); pos != std::string_view::npos; pos = s.find(def::var_sv, pos + 1u)) {
+			if (s.find('}', pos) == std::string_view::npos) report("unterminated interpolation");
+		}
+		bool descend = true;
+		if (svmatch m; s.starts_with(def::folding_sv) || std::regex_match(s.cbegin(), s.cend(), def::comment_re) || std::regex_match(s.cbegin(), s.cend(), def::block_re) || std::regex_match(s.cbegin(), s.cend(), def::break_re)) {
+			// There is nothing to validate.
+		} else if (std::regex_match(s.cbegin(), s.cend(), m, def::include_re) || std::regex_match(s.cbegin(), s.cend(), m, def::extends_re)) {
+			auto const pug = std::filesystem::path{path}.replace_filename(to_str(s, m, 1)).lexically_normal();
+			if (std::ranges::find(chain, pug) != chain.cend()) {
+				report("recursive include '" + std::string{to_str(s, m, 1)} + "'");
+			} else if (std::error_code ec; ! std::filesystem::is_regular_file(pug, ec)) {
+				report("missing file '" + std::string{to_str(s, m, 1)} + "'");
+			} else {
+				check_file(pug, path, chain, out);
+			}
+		} else if (std::regex_match(s.cbegin(), s.cend(), m, def::if_re) || std::regex_match(s.cbegin(), s.cend(), m, def::elif_re)) {
+			if (s.starts_with("else") && ! follows_if()) report("'else if' without 'if'");
+			if (auto const e = check_expression(to_str(s, m, 1), def::compare_ops); e) report(*e);
+		} else if (std::regex_match(s.cbegin(), s.cend(), def::else_re)) {
+			if (! follows_if()) report("'else' without 'if'");
+		} else if (std::regex_match(s.cbegin(), s.cend(), def::case_re)) {
+			frames.push_back({line->children(), 0u, std::set<std::string_view>{}});	   // Children are validated as labels.
+			descend = false;
+		} else if (std::regex_match(s.cbegin(), s.cend(), m, def::for_re)) {
+			if (! is_operand(to_str(s, m, 2))) report("invalid initial value '" + std::string{to_str(s, m, 2)} + "'");
+			if (auto const e = check_expression(to_str(s, m, 3), def::compare_ops); e) report(*e);
+			if (auto const e = check_expression(to_str(s, m, 4), def::assign_ops); e) report(*e);
+		} else if (std::regex_match(s.cbegin(), s.cend(), m, def::each_re)) {
+			std::istringstream iss(std::string{to_str(s, m, 2)});
+			for (std::string item; std::getline(iss, item, ',');) {
+				auto const begin = item.find_first_not_of(" \t");
+				if (begin == std::string::npos) {
+					report("empty item");
+				} else if (auto const i = item.substr(begin, item.find_last_not_of(" \t,") - begin + 1); ! is_quoted(i)) {
+					report("unbalanced quotes '" + i + "'");
+				}
+			}
+		} else if (std::regex_match(s.cbegin(), s.cend(), m, def::var_re) || std::regex_match(s.cbegin(), s.cend(), m, def::const_re)) {
+			if (! is_quoted(to_str(s, m, 2))) report("unbalanced quotes '" + std::string{to_str(s, m, 2)} + "'");
+		} else if (std::regex_match(s.cbegin(), s.cend(), def::when_re)) {
+			report("'when' without 'case'");
+		} else if (s == def::raw_html_sv) {
+			descend = false;	// Children are raw text.
+		} else {
+			try {
+				for (auto rest = s; ! rest.empty();) {
+					rest = std::get<0>(parse_element(rest, line));
+				}
+			} catch (ex::syntax_error const&) {
+				report("invalid element '" + std::string{s} + "'");
+			}
+		}
+		if (descend) frames.push_back({line->children(), 0u, std::nullopt});
+	}
+}
+
+///	@brief	Validates the pug @p source without rendering.
+///	@param[in]		source		Pug source.
+///	@param[in]		file		Path of the @p source to report.
+///	@param[in]		path		Path of the top-level pug, from which included files are resolved.
+///	@param[in,out]	chain		Files including the @p source, to find recursive includes.
+///	@param[in,out]	out			Errors found.
+inline void check_source(std::string_view source, std::filesystem::path const& file, std::filesystem::path const& path, std::vector<std::filesystem::path>& chain, std::vector<diagnostic_t>& out) {
+	std::shared_ptr<line_node_t const> root;
+	try {
+		root = parse_file(source);
+	} catch (ex::syntax_error const&) {
+		// Only a folding line at the top fails to build the tree.
+		auto const lines = split_lines(source);
+		auto const top	 = std::ranges::find_if(lines, [](auto const& a) { return get_line_nest(a).second.starts_with(def::folding_sv); });
+		out.push_back({file, top == lines.cend() ? 0u : get_line_number(source, *top), "folding text without element"});
+		return;
+	}
+	chain.push_back(file.lexically_normal());
+	check_lines(root, source, file, path, chain, out);
+	chain.pop_back();
+}
+
+///	@brief	Validates the pug @p file without rendering.
+///	@param[in]		file		Path of the pug file.
+///	@param[in]		path		Path of the top-level pug, from which included files are resolved.
+///	@param[in,out]	chain		Files including the @p file, to find recursive includes.
+///	@param[in,out]	out			Errors found.
+inline void check_file(std::filesystem::path const& file, std::filesystem::path const& path, std::vector<std::filesystem::path>& chain, std::vector<diagnostic_t>& out) {
+	try {
+		auto const source = load_file(file);
+		check_source(source, file, path, chain, out);
+	} catch (ex::io_error const& e) {
+		out.push_back({file, 0u, e.code().message()});
+	}
+}
+
+///	@brief	Renders the @p line chunk by chunk.
+///		Elements are opened before their children are rendered,
+///		so that the generated HTML is yielded as soon as it is complete.
+///		Other directives are rendered as a whole by the parse_line().
+///		Nested elements, blocks and included files are rendered with the explicit stack instead of nested coroutines.
+///	@param[in,out]	context		Parsing context. It is updated as the parse_line() returns.
+///	@param[in]		line		Line of the pug.
+///	@param[in]		path		Path of the pug.
+///	@param[in,out]	buffer		Generated HTML not yielded yet.
+///	@param[in]		chunk_size	Size to yield a chunk.
+///	@return		Generator of chunks, each of which is the @p chunk_size or larger.
+///				The remaining HTML less than the @p chunk_size is kept in the @p buffer.
+inline generator<std::string> render_chunks(context_t& context, std::shared_ptr<line_node_t const> line, std::filesystem::path const& path, std::string& buffer, std::size_t chunk_size) {
+	std::pmr::vector<frame_t> frames{context.resource()};
+	frames.push_back({nullptr, {line}, 0u, {}, nullptr});
+	while (! frames.empty()) {
+		auto& frame = frames.back();
+		if (frame.next == frame.children.size()) {
+			if (frame.line) buffer += close_elements(context, frame.line, std::move(frame.tags));
+			if (frame.source) {
+				context.set_depth(context.depth() - 1u);
+				context.keep(std::move(frame.source));
+			}
+			frames.pop_back();
+			if (chunk_size <= buffer.size()) co_yield std::exchange(buffer, std::string{});
+			continue;
+		}
+
+		auto const l = frame.children[frame.next++];
+		if (auto* const governor = context.options().governor; governor) governor->check();
+		auto const& s = l->line();
+		if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::include_re) || std::regex_match(s.cbegin(), s.cend(), m, def::extends_re)) {
+			// Opens an including pug file from relative path of the current pug.
+			auto const pug	  = std::filesystem::path{path}.replace_filename(to_str(s, m, 1));
+			auto const source = load_dependency(context, pug);	  // This string is kept while the frame renders it.
+			context.set_depth(context.depth() + 1u);
+			frames.push_back({nullptr, {parse_file(*source, l->nest(), context.resource())}, 0u, {}, source});
+		} else if (std::regex_match(s.cbegin(), s.cend(), m, def::block_re) && context.has_block(to_str(s, m, 1))) {
+			frames.push_back({nullptr, context.block(to_str(s, m, 1))->children(), 0u, {}, nullptr});
+		} else if (is_element(context, *l)) {
+			auto [open, tags] = open_elements(context, l);
+			buffer += open;
+			frames.push_back({l, l->children(), 0u, std::move(tags), nullptr});
+			if (chunk_size <= buffer.size()) co_yield std::exchange(buffer, std::string{});
+		} else {
+			auto [out, ctx] = parse_line(context, l, path);
+			context			= std::move(ctx);
+			buffer += out;
+			if (chunk_size <= buffer.size()) co_yield std::exchange(buffer, std::string{});
+		}
+	}
+}
+
+///	@brief	Renders the @p line into the @p segments.
+///		Text lifted from the source, such as folded text, raw blocks and text of elements, is referred without copying
+///		unless it includes variables. Other HTML is copied as the parse_line() returns.
+///		Nested elements, blocks and included files are rendered with the explicit stack instead of recursion.
+///	@param[in,out]	context		Parsing context. It is updated as the parse_line() returns.
+///	@param[in]		line		Line of the pug.
+///	@param[in]		path		Path of the pug.
+///	@param[in,out]	segments	Scatter-gather list to append.
+inline void render_segments(context_t& context, std::shared_ptr<line_node_t const> line, std::filesystem::path const& path, segments_t& segments) {
+	// It appends the @p html, referring its suffix in the @p source if they are the same.
+	auto const append = [&segments](std::string_view html, std::string_view source) {
+		auto const body = html.ends_with('\n') ? html.substr(0u, html.size() - 1u) : html;
+		auto const n	= static_cast<std::size_t>(std::ranges::mismatch(body | std::views::reverse, source | std::views::reverse).in1.base() - body.begin());
+		segments.copy(body.substr(0u, n));
+		segments.append(source.substr(source.size() - (body.size() - n)));
+		segments.copy(html.substr(body.size()));
+	};
+
+	std::pmr::vector<frame_t> frames{context.resource()};
+	frames.push_back({nullptr, {line}, 0u, {}, nullptr});
+	while (! frames.empty()) {
+		auto& frame = frames.back();
+		if (frame.next == frame.children.size()) {
+			if (frame.line) segments.copy(close_elements(context, frame.line, std::move(frame.tags)));
+			if (frame.source) {
+				context.set_depth(context.depth() - 1u);
+				context.keep(std::move(frame.source));
+			}
+			frames.pop_back();
+			continue;
+		}
+
+		auto const l = frame.children[frame.next++];
+		if (auto* const governor = context.options().governor; governor) governor->check();
+		auto const& s = l->line();
+		if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::include_re) || std::regex_match(s.cbegin(), s.cend(), m, def::extends_re)) {
+			// Opens an including pug file from relative path of the current pug.
+			auto const pug	  = std::filesystem::path{path}.replace_filename(to_str(s, m, 1));
+			auto const source = load_dependency(context, pug);
+			(void)segments.keep(source);	// Views of the source are kept.
+			context.set_depth(context.depth() + 1u);
+			frames.push_back({nullptr, {parse_file(*source, l->nest(), context.resource())}, 0u, {}, source});
+		} else if (std::regex_match(s.cbegin(), s.cend(), m, def::block_re) && context.has_block(to_str(s, m, 1))) {
+			frames.push_back({nullptr, context.block(to_str(s, m, 1))->children(), 0u, {}, nullptr});
+		} else if (s.starts_with(def::folding_sv) && s.find(def::var_sv) == std::string_view::npos) {
+			context.output(s.size() - def::folding_sv.size());
+			segments.append(s.substr(def::folding_sv.size()));
+		} else if (s == def::raw_html_sv) {
+			auto [open, tags] = open_elements(context, l);
+			if (std::ranges::any_of(l->children(), [](auto const& a) { return a->line().find(def::var_sv) != std::string_view::npos; })) {
+				segments.copy(open);
+			} else {
+				for (std::string_view html{open}; auto const& child: l->children()) {
+					auto const n = child->nest() + child->line().size() + 1u;
+					append(html.substr(0u, n), child->line());
+					html = html.substr(n);
+				}
+			}
+			frames.push_back({l, l->children(), 0u, std::move(tags), nullptr});
+		} else if (is_element(context, *l)) {
+			auto [open, tags] = open_elements(context, l);
+			append(open, s);
+			frames.push_back({l, l->children(), 0u, std::move(tags), nullptr});
+		} else {
+			auto [out, ctx] = parse_line(context, l, path);
+			context			= std::move(ctx);
+			segments.copy(out);
+		}
+	}
+}
+
+///	@brief	Names of the variables that a subtree reads and writes.
+struct subtree_t {
+	std::set<std::string_view> reads;	  ///< @brief	Names of the variables that the subtree reads.
+	std::set<std::string_view> writes;	  ///< @brief	Names of the variables that the subtree may write.
+	bool					   pure{};	  ///< @brief	Whether the subtree neither loads other files nor defines blocks.
+};
+
+///	@brief	Summarizes every subtree of the @p root.
+///		The subtree of an 'if' line includes its 'else if' and 'else' branches, which are rendered by it.
+///	@param[in]		root		The root of the nodes.
+///	@param[in,out]	subtrees	Summaries of the subtrees by their roots to add.
+inline void get_subtrees(std::shared_ptr<line_node_t const> const& root, std::unordered_map<line_node_t const*, subtree_t>& subtrees) {
+	// Nodes are summarized in the reverse of the pre-order, so that children are summarized before their parents.
+	std::vector<line_node_t const*> order;
+	for (std::vector<std::shared_ptr<line_node_t const>> lines{root}; ! lines.empty();) {
+		auto const node = std::move(lines.back());
+		lines.pop_back();
+		order.push_back(node.get());
+		std::ranges::copy(node->children(), std::back_inserter(lines));
+	}
+	for (auto const* node: order | std::views::reverse) {
+		auto const& s = node->line();
+		subtree_t	subtree{{}, {}, true};
+		std::ranges::for_each(get_references(s), [&subtree](auto const& r) { subtree.reads.insert(r); });
+		if (svmatch m; std::regex_match(s.cbegin(), s.cend(), m, def::var_re) || std::regex_match(s.cbegin(), s.cend(), m, def::const_re) || std::regex_match(s.cbegin(), s.cend(), m, def::each_re) || std::regex_match(s.cbegin(), s.cend(), m, def::for_re)) {
+			subtree.writes.insert(to_str(s, m, 1));
+		}
+		subtree.pure = std::ranges::none_of(std::initializer_list<std::regex const*>{&def::include_re, &def::extends_re, &def::block_re}, [s](auto const* re) { return std::regex_match(s.cbegin(), s.cend(), *re); });
+		for (auto const& child: node->children()) {
+			auto const& sub = subtrees.at(child.get());
+			subtree.reads.insert(sub.reads.cbegin(), sub.reads.cend());
+			subtree.writes.insert(sub.writes.cbegin(), sub.writes.cend());
+			subtree.pure = subtree.pure && sub.pure;
+		}
+		subtrees.insert_or_assign(node, std::move(subtree));
+	}
+	for (auto const* node: order) {
+		for (auto const& [condition, branch]: node->branches()) {
+			if (! branch) continue;
+			auto const	sub		= subtrees.at(branch.get());
+			auto&		subtree = subtrees.at(node);
+			subtree.reads.insert(sub.reads.cbegin(), sub.reads.cend());
+			subtree.writes.insert(sub.writes.cbegin(), sub.writes.cend());
+			subtree.pure = subtree.pure && sub.pure;
 		}
-		return {oss.str(), ctx};
 	}
 }
 
+///	@brief	Replacement of a range of HTML.
+struct patch_t {
+	std::size_t offset{};	 ///< @brief	Offset of the range in the previous HTML.
+	std::size_t length{};	 ///< @brief	Length of the range in the previous HTML.
+	std::string text;		 ///< @brief	HTML replacing the range.
+
+	auto operator<=>(patch_t const&) const = default;
+};
+
+///	@brief	Gets the patches from the @p before to the @p after.
+///		Ranges copied from the @p before are kept, and the others are replaced without their common prefixes and suffixes.
+///	@param[in]	before	The previous HTML.
+///	@param[in]	after	The current HTML.
+///	@param[in]	kept	Ranges copied from the @p before in order; offset in the @p after, offset in the @p before, and length.
+///	@return		Patches in order of their offsets. Their ranges never overlap.
+inline std::vector<patch_t> get_patches(std::string_view before, std::string_view after, std::vector<std::tuple<std::size_t, std::size_t, std::size_t>> const& kept) {
+	std::vector<patch_t> patches;
+	std::size_t			 before_end = 0u, after_end = 0u;
+	// It replaces the gap between the ends and the beginnings.
+	auto const replace = [&](std::size_t before_begin, std::size_t after_begin) {
+		auto	   b	  = before.substr(before_end, before_begin - before_end);
+		auto	   a	  = after.substr(after_end, after_begin - after_end);
+		auto const prefix = static_cast<std::size_t>(std::ranges::mismatch(b, a).in1 - b.begin());
+		b.remove_prefix(prefix);
+		a.remove_prefix(prefix);
+		auto const suffix = static_cast<std::size_t>(std::ranges::mismatch(b | std::views::reverse, a | std::views::reverse).in1 - b.rbegin());
+		b.remove_suffix(suffix);
+		a.remove_suffix(suffix);
+		if (! b.empty() || ! a.empty()) patches.push_back({before_end + prefix, b.size(), std::string{a}});
+	};
+	for (auto const& [after_begin, before_begin, size]: kept) {
+		if (before_begin < before_end) continue;	// It is moved backward, so that it is replaced.
+		replace(before_begin, after_begin);
+		before_end = before_begin + size;
+		after_end  = after_begin + size;
+	}
+	replace(before.size(), after.size());
+	return patches;
+}
+
 }	 // namespace impl
 
+///	@brief	Version of this translator. Outputs may differ between versions.
+static constexpr std::string_view version{"1.0.0"};
+
+using variables_t = impl::context_t::variables_t;	///< @brief	Map of variables.
+using options_t	  = impl::options_t;				///< @brief	Rendering options.
+using fragment_cache_t = impl::fragment_cache_t;	///< @brief	Cache of rendered fragments.
+using interner_t		   = impl::interner_t;			///< @brief	Interner of subtrees shared by compiled templates.
+using segments_t	   = impl::segments_t;			///< @brief	Scatter-gather list of generated HTML.
+using limits_t		   = impl::limits_t;			///< @brief	Resource limits of a rendering.
+using diagnostic_t	   = impl::diagnostic_t;		///< @brief	Error found by validation.
+using governor_t	   = impl::governor_t;			///< @brief	Governor of resources of a rendering.
+using loader_t		   = impl::loader_t;			///< @brief	Loader of included and extended pug files.
+using file_loader_t	   = impl::file_loader_t;		///< @brief	Loader reading pug files from the filesystem.
+using memory_loader_t  = impl::memory_loader_t;		///< @brief	Loader of pug files in memory.
+using patch_t		   = impl::patch_t;				///< @brief	Replacement of a range of HTML.
+
 ///	@brief	Translates a pug string to HTML string.
 ///	@param[in]	pug		Source string formatted in pug.
 ///	@param[in]	path	Path of working directory.
+///	@param[in]	options	Rendering options.
 ///	@return		String of generated HTML.
-inline std::string pug_string(std::string_view pug, std::filesystem::path const& path = "./") {
-	auto const root		  = impl::parse_file(pug);
-	auto const [out, ctx] = impl::parse_line(impl::context_t{}, root, path);
+inline std::string pug_string(std::string_view pug, std::filesystem::path const& path = "./", options_t const& options = options_t{}) {
+	auto const root		  = impl::parse_file(pug, 0u, impl::get_resource(options));
+	auto const [out, ctx] = impl::parse_line(impl::context_t{variables_t{}, options}, root, path);
 	return out;
 }
 
 ///	@brief	Translates a pug file to HTML string.
 ///	@param[in]	path	Path of the pug file.
+///	@param[in]	options	Rendering options.
 ///	@return		String of generated HTML.
-inline std::string pug_file(std::filesystem::path const& path) {
+inline std::string pug_file(std::filesystem::path const& path, options_t const& options = options_t{}) {
 	auto const source = impl::load_file(path);
-	return pug_string(source, path);
+	return pug_string(source, path, options);
 }
 
-using variables_t = impl::context_t::variables_t;	///< @brief	Map of variables.
-
 ///	@brief	Translates a pug string to HTML string.
 ///	@param[in]	variables	Variables.
 ///	@param[in]	pug			Source string formatted in pug.
 ///	@param[in]	path		Path of working directory.
+///	@param[in]	options		Rendering options.
 ///	@return		String of generated HTML.
-inline std::string pug_string_with_variables(variables_t const& variables, std::string_view pug, std::filesystem::path const& path = "./") {
-	auto const root	 = impl::parse_file(pug);
-	auto const [out, ctx] = impl::parse_line(impl::context_t{variables}, root, path);
+inline std::string pug_string_with_variables(variables_t const& variables, std::string_view pug, std::filesystem::path const& path = "./", options_t const& options = options_t{}) {
+	auto const root		  = impl::parse_file(pug, 0u, impl::get_resource(options));
+	auto const [out, ctx] = impl::parse_line(impl::context_t{variables, options}, root, path);
 	return out;
 }
 
 ///	@brief	Translates a pug file to HTML string.
 ///	@param[in]	variables	Variables.
-///	@param[in]	path	Path of the pug file.
+///	@param[in]	path		Path of the pug file.
+///	@param[in]	options		Rendering options.
 ///	@return		String of generated HTML.
-inline std::string pug_file_with_variables(variables_t const& variables, std::filesystem::path const& path) {
+inline std::string pug_file_with_variables(variables_t const& variables, std::filesystem::path const& path, options_t const& options = options_t{}) {
 	auto const source = impl::load_file(path);
-	return pug_string_with_variables(variables, source, path);
+	return pug_string_with_variables(variables, source, path, options);
 }
 
+class session_t;
+
+///	@brief	Compiled template.
+///		It keeps the pug source and its parsed nodes to translate it repeatedly.
+///		It is immutable, so that it can be shared and translated by several threads at once.
+class template_t {
+	friend class session_t;
+
+public:
+	///	@brief	Translates the template to HTML string.
+	///	@param[in]	variables	Variables.
+	///	@param[in]	options		Rendering options.
+	///	@return		String of generated HTML.
+	std::string render(variables_t const& variables = variables_t{}, options_t const& options = options_t{}) const {
+		auto const [out, ctx] = impl::parse_line(bind(variables, options), root_, path_);
+		return out;
+	}
+	///	@brief	Binds the variables to the slots of the template.
+	///		Variables the template refers are looked up by indices while rendering.
+	///	@param[in]	variables	Variables.
+	///	@param[in]	options		Rendering options.
+	///	@return		Parsing context to render the template. It refers the slots of the template.
+	impl::context_t bind(variables_t const& variables, options_t const& options = options_t{}) const {
+		return impl::context_t{variables, options, slots_.get()};
+	}
+	///	@brief	Translates the template to HTML chunk by chunk.
+	///	@param[in,out]	context		Parsing context.
+	///	@param[in,out]	buffer		Generated HTML not yielded yet.
+	///	@param[in]		chunk_size	Size to yield a chunk.
+	///	@return		Generator of the chunks of HTML.
+	impl::generator<std::string> render_chunks(impl::context_t& context, std::string& buffer, std::size_t chunk_size) const {
+		return impl::render_chunks(context, root_, path_, buffer, chunk_size);
+	}
+	///	@brief	Translates the template to a scatter-gather list of HTML.
+	///		Text lifted from the source is referred without copying, so that it can be written by writev() at once.
+	///	@param[in,out]	segments	Scatter-gather list to append. It keeps the source alive.
+	///	@param[in]		variables	Variables.
+	///	@param[in]		options		Rendering options.
+	void render_segments(segments_t& segments, variables_t const& variables = variables_t{}, options_t const& options = options_t{}) const {
+		auto context = bind(variables, options);
+		(void)segments.keep(source_);
+		segments.keep(root_);	 // Interned nodes refer their own strings.
+		impl::render_segments(context, root_, path_, segments);
+	}
+	///	@brief	Translates the template to a scatter-gather list of HTML.
+	///	@param[in]	variables	Variables.
+	///	@param[in]	options		Rendering options.
+	///	@return		Scatter-gather list of generated HTML. It keeps the source alive.
+	segments_t render_segments(variables_t const& variables = variables_t{}, options_t const& options = options_t{}) const {
+		segments_t segments;
+		render_segments(segments, variables, options);
+		return segments;
+	}
+	///	@brief	Gets the path of the template.
+	///	@return		Path of the template. Included pug files are resolved from it.
+	auto const& path() const noexcept { return path_; }
+	///	@brief	Gets the source of the template.
+	///	@return		Source string formatted in pug.
+	auto const& source() const noexcept { return *source_; }
+
+	///	@brief	Constructor.
+	///	@param[in]	pug			Source string formatted in pug.
+	///	@param[in]	path		Path of working directory.
+	///	@param[in]	resource	Memory resource of the parsed nodes.
+	///	@param[in]	interner	Interner sharing identical subtrees with other templates. It is null not to share them.
+	///	@warning	Keep the @p resource and the @p interner available while the template is alive.
+	explicit template_t(std::string pug, std::filesystem::path const& path = "./", std::pmr::memory_resource* resource = std::pmr::get_default_resource(), interner_t* interner = nullptr) :
+		source_{std::make_shared<std::string const>(std::move(pug))}, root_{impl::compile(*source_, resource, interner)}, slots_{std::make_shared<impl::slots_t const>(impl::get_slots(*root_))}, path_{path} {}
+
+private:
+	std::shared_ptr<std::string const>		 source_;	 ///< @brief	Source string. Nodes refer views of it.
+	std::shared_ptr<impl::line_node_t const> root_;		 ///< @brief	The root of parsed nodes.
+	std::shared_ptr<impl::slots_t const>	 slots_;	 ///< @brief	Slots of the variables that the nodes refer.
+	std::filesystem::path					 path_;		 ///< @brief	Path of the template.
+};
+
+///	@brief	Translates the template to HTML chunk by chunk.
+///		A chunk is yielded as soon as its HTML is complete, so that it can be flushed before the whole is rendered.
+///		For example, the doctype and the head of the layout are yielded while the following loops are still rendering.
+///	@param[in]	compiled	Compiled template.
+///	@param[in]	variables	Variables.
+///	@param[in]	options		Rendering options.
+///	@param[in]	chunk_size	Threshold to yield a chunk. Each chunk is this size or larger except the last one.
+///	@return		Generator of the chunks of HTML.
+inline impl::generator<std::string> render_chunks(template_t compiled, variables_t variables = variables_t{}, options_t options = options_t{}, std::size_t chunk_size = impl::def::chunk_size) {
+	auto		context = compiled.bind(variables, options);
+	std::string buffer;
+	for (auto&& chunk: compiled.render_chunks(context, buffer, chunk_size)) {
+		co_yield std::move(chunk);
+	}
+	if (! buffer.empty()) co_yield std::move(buffer);
+}
+
+///	@brief	Validates a pug string without rendering.
+///		It collects all the errors, including ones of included files, instead of throwing the first one.
+///	@param[in]	pug		Source string formatted in pug.
+///	@param[in]	path	Path of the pug, from which included files are resolved.
+///	@return		Errors found. It is empty if the @p pug is valid.
+inline std::vector<diagnostic_t> check_string(std::string_view pug, std::filesystem::path const& path = "./") {
+	std::vector<diagnostic_t>		   out;
+	std::vector<std::filesystem::path> chain;
+	impl::check_source(pug, path, path, chain, out);
+	return out;
+}
+
+///	@brief	Validates a pug file without rendering.
+///		It collects all the errors, including ones of included files, instead of throwing the first one.
+///	@param[in]	path	Path of the pug file.
+///	@return		Errors found. It is empty if the file is valid.
+inline std::vector<diagnostic_t> check_file(std::filesystem::path const& path) {
+	std::vector<diagnostic_t>		   out;
+	std::vector<std::filesystem::path> chain;
+	impl::check_file(path, path, chain, out);
+	return out;
+}
+
+///	@brief	Compiles a pug file to a template.
+///	@param[in]	path		Path of the pug file.
+///	@param[in]	resource	Memory resource of the parsed nodes.
+///	@return		Compiled template.
+///	@warning	Keep the @p resource available while the template is alive.
+inline template_t compile_file(std::filesystem::path const& path, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+	return template_t{impl::load_file(path), path, resource};
+}
+
+///	@brief	Compiles a pug file loaded by the @p loader to a template.
+///		Render it with the same loader in the options to resolve its includes and extends.
+///	@param[in]	path		Path of the pug file.
+///	@param[in]	loader		Loader of the pug file.
+///	@param[in]	resource	Memory resource of the parsed nodes.
+///	@return		Compiled template.
+///	@warning	Keep the @p resource available while the template is alive.
+inline template_t compile_file(std::filesystem::path const& path, loader_t const& loader, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+	return template_t{*loader.load(path), path, resource};
+}
+
+///	@brief	Applies the patches to the HTML.
+///	@param[in,out]	html		The previous HTML to patch.
+///	@param[in]		patches		Patches in order of their offsets.
+inline void apply_patches(std::string& html, std::vector<patch_t> const& patches) {
+	for (auto const& a: patches | std::views::reverse) {
+		html.replace(a.offset, a.length, a.text);
+	}
+}
+
+///	@brief	Session re-rendering a template incrementally as its variables are updated.
+///		It remembers the range of HTML rendered from each line and the variables that its subtree reads.
+///		When variables are updated, subtrees reading none of them are copied from the previous HTML instead of rendered,
+///		and the differences are returned as patches; e.g., to update a live dashboard.
+///		Included and extended files are loaded once per session.
+class session_t {
+public:
+	///	@brief	Gets the current HTML.
+	///	@return		The current HTML.
+	std::string const& html() const noexcept { return html_; }
+	///	@brief	Updates the variables and re-renders the subtrees affected by them.
+	///	@param[in]	variables	Variables to add or to update. The others are kept.
+	///	@return		Patches from the previous HTML to the current one. It is empty if nothing is changed.
+	std::vector<patch_t> update(variables_t const& variables) {
+		std::unordered_set<std::string_view> changed;
+		for (auto const& [name, value]: variables) {
+			if (auto const itr = values_.find(name); itr == values_.end()) {
+				changed.insert(values_.emplace(name, value).first->first);
+			} else if (itr->second != value) {
+				itr->second = value;
+				changed.insert(itr->first);
+			}
+		}
+		return changed.empty() ? std::vector<patch_t>{} : render(std::move(changed));
+	}
+
+	///	@brief	Constructor.
+	///		It renders the template at first.
+	///	@param[in]	compiled	Compiled template.
+	///	@param[in]	variables	Variables.
+	///	@param[in]	options		Rendering options.
+	explicit session_t(template_t compiled, variables_t const& variables = variables_t{}, options_t const& options = options_t{}) :
+		compiled_{std::move(compiled)}, options_{options}, values_{variables.cbegin(), variables.cend()}, html_{}, records_{}, index_{}, subtrees_{}, included_{} {
+		impl::get_subtrees(compiled_.root_, subtrees_);
+		(void)render({});
+	}
+
+private:
+	///	@brief	Range of HTML rendered from a line.
+	struct record_t {
+		impl::line_node_t const*								line;			  ///< @brief	The line.
+		std::size_t												occurrence;		  ///< @brief	Count of the line rendered before it.
+		std::size_t												begin;			  ///< @brief	Offset of the range.
+		std::size_t												end;			  ///< @brief	End of the range.
+		std::size_t												descendants;	  ///< @brief	Count of the records following it in its range.
+		std::vector<std::pair<std::string_view, std::string>>	writes;			  ///< @brief	Variables written by the line.
+	};
+	///	@brief	Frame of the explicit stack to render.
+	struct rendering_t {
+		impl::frame_t frame;	 ///< @brief	Frame to render.
+		std::size_t	  record;	 ///< @brief	Index of the record of the frame, which is closed when the frame ends.
+	};
+
+	///	@brief	Re-renders the template.
+	///	@param[in]	changed		Names of the changed variables. Names written by re-rendered lines are added while rendering.
+	///	@return		Patches from the previous HTML to the current one.
+	std::vector<patch_t> render(std::unordered_set<std::string_view> changed) {
+		variables_t variables;
+		std::ranges::for_each(values_, [&variables](auto const& a) { variables.emplace(a.first, a.second); });
+		auto		context = compiled_.bind(variables, options_);
+		auto const& path	= compiled_.path_;
+
+		std::string												  html;
+		std::vector<record_t>									  records;
+		std::unordered_map<impl::line_node_t const*, std::size_t> occurrences;
+		std::vector<std::tuple<std::size_t, std::size_t, std::size_t>> kept;
+		std::vector<rendering_t>								  frames;
+		frames.push_back({{nullptr, {compiled_.root_}, 0u, {}, nullptr}, std::numeric_limits<std::size_t>::max()});
+		while (! frames.empty()) {
+			auto& frame = frames.back().frame;
+			if (frame.next == frame.children.size()) {
+				if (frame.line) html += impl::close_elements(context, frame.line, std::move(frame.tags));
+				if (frame.source) context.set_depth(context.depth() - 1u);
+				if (auto const index = frames.back().record; index < records.size()) {
+					records[index].end		   = html.size();
+					records[index].descendants = records.size() - index - 1u;
+				}
+				frames.pop_back();
+				continue;
+			}
+
+			auto const l = frame.children[frame.next++];
+			if (! l) continue;
+			if (auto* const governor = context.options().governor; governor) governor->check();
+			auto const& subtree	   = subtrees_.at(l.get());
+			auto const	occurrence = occurrences[l.get()]++;
+			auto const	previous   = index_.find({l.get(), occurrence});
+			if (previous != index_.cend() && is_clean(context, subtree, changed)) {
+				// The subtree is copied from the previous HTML with the records in it.
+				auto const& record = records_[previous->second];
+				auto const	offset = html.size();
+				html.append(html_, record.begin, record.end - record.begin);
+				context.output(record.end - record.begin);
+				kept.emplace_back(offset, record.begin, record.end - record.begin);
+				for (auto i = previous->second; i <= previous->second + record.descendants; ++i) {
+					auto& r = records.emplace_back(records_[i]);
+					if (i != previous->second) r.occurrence = occurrences[r.line]++;
+					r.begin = r.begin + offset - record.begin;
+					r.end	= r.end + offset - record.begin;
+					std::ranges::for_each(r.writes, [&context](auto const& a) { context.set_variable(a.first, a.second); });
+				}
+				continue;
+			}
+
+			auto const index = records.size();
+			records.push_back({l.get(), occurrence, html.size(), html.size(), 0u, {}});
+			auto const& s = l->line();
+			if (impl::svmatch m; std::regex_match(s.cbegin(), s.cend(), m, impl::def::include_re) || std::regex_match(s.cbegin(), s.cend(), m, impl::def::extends_re)) {
+				// Opens an including pug file from relative path of the current pug, which is parsed once per session.
+				auto const& [source, root] = load(context, std::filesystem::path{path}.replace_filename(impl::to_str(s, m, 1)), l->nest());
+				context.set_depth(context.depth() + 1u);
+				frames.push_back({{nullptr, {root}, 0u, {}, source}, index});
+			} else if (std::regex_match(s.cbegin(), s.cend(), m, impl::def::block_re) && context.has_block(impl::to_str(s, m, 1))) {
+				frames.push_back({{nullptr, context.block(impl::to_str(s, m, 1))->children(), 0u, {}, nullptr}, index});
+			} else if (impl::is_element(context, *l)) {
+				auto [open, tags] = impl::open_elements(context, l);
+				html += open;
+				frames.push_back({{l, l->children(), 0u, std::move(tags), nullptr}, index});
+			} else {
+				auto [out, ctx] = impl::parse_line(context, l, path);
+				auto& record	= records[index];
+				for (auto const& name: subtree.writes) {
+					if (ctx.has_variable(name) && (! context.has_variable(name) || context.variable(name) != ctx.variable(name))) {
+						record.writes.emplace_back(name, ctx.variable(name));
+					}
+				}
+				// Lines reading the variables written by it are re-rendered if they are changed.
+				if (previous == index_.cend() || records_[previous->second].writes != record.writes) {
+					changed.insert(subtree.writes.cbegin(), subtree.writes.cend());
+				}
+				context = std::move(ctx);
+				html += out;
+				record.end = html.size();
+			}
+		}
+
+		auto patches = impl::get_patches(html_, html, kept);
+		html_		 = std::move(html);
+		records_	 = std::move(records);
+		index_.clear();
+		for (std::size_t i = 0u; i < records_.size(); ++i) {
+			index_.emplace(std::make_pair(records_[i].line, records_[i].occurrence), i);
+		}
+		return patches;
+	}
+	///	@brief	Gets whether the subtree renders the same HTML as the previous one or not.
+	///	@param[in]	context		Parsing context.
+	///	@param[in]	subtree		Summary of the subtree.
+	///	@param[in]	changed		Names of the changed variables.
+	///	@return		It returns true if the subtree is clean; otherwise, it returns false.
+	static bool is_clean(impl::context_t const& context, impl::subtree_t const& subtree, std::unordered_set<std::string_view> const& changed) {
+		if (! subtree.pure || std::ranges::any_of(changed, [&subtree](auto const& a) { return subtree.reads.contains(a); })) return false;
+		// A variable whose value has another variable to replace may be changed indirectly.
+		return std::ranges::none_of(subtree.reads, [&context](auto const& a) { return context.has_variable(a) && context.variable(a).find(impl::def::var_sv) != std::string::npos; });
+	}
+	///	@brief	Loads the pug file included or extended, and parses it once per session.
+	///	@param[in]	context		Parsing context.
+	///	@param[in]	path		Path of the pug file.
+	///	@param[in]	nest		Nested level of the including line.
+	///	@return		Source and the root of the pug file.
+	std::pair<std::shared_ptr<std::string const>, std::shared_ptr<impl::line_node_t const>> const& load(impl::context_t const& context, std::filesystem::path const& path, impl::nest_t nest) {
+		auto key = std::make_pair(path.string(), nest);
+		if (auto const itr = included_.find(key); itr != included_.cend()) return itr->second;
+		auto source = impl::load_dependency(context, path);
+		auto root	= std::shared_ptr<impl::line_node_t const>{impl::parse_file(*source, nest)};
+		impl::get_subtrees(root, subtrees_);
+		return included_.emplace(std::move(key), std::make_pair(std::move(source), std::move(root))).first->second;
+	}
+
+	template_t																			compiled_;	  ///< @brief	Compiled template.
+	options_t																			options_;	  ///< @brief	Rendering options.
+	std::map<std::string, std::string, std::less<>>										values_;	  ///< @brief	Current variables. Views of their names are kept.
+	std::string																			html_;		  ///< @brief	Current HTML.
+	std::vector<record_t>																records_;	  ///< @brief	Ranges of the current HTML in order of rendering.
+	std::map<std::pair<impl::line_node_t const*, std::size_t>, std::size_t>				index_;		  ///< @brief	Indices of the records by their lines and occurrences.
+	std::unordered_map<impl::line_node_t const*, impl::subtree_t>						subtrees_;	  ///< @brief	Summaries of the subtrees.
+	std::map<std::pair<std::string, impl::nest_t>, std::pair<std::shared_ptr<std::string const>, std::shared_ptr<impl::line_node_t const>>> included_;	  ///< @brief	Included and extended pug files.
+};
+
+///	@brief	Pug document edited line by line; e.g., by an editor previewing it.
+///		An edit parses lines again from the edited ones, and it stops at the first unchanged line appended to the same node as before,
+///		where the nodes following it are attached again as they are. Only the edited lines and the nodes enclosing them are visited,
+///		and conditional chains around them are linked again, so that the tree is the same as the one parsed from the whole source.
+class document_t {
+public:
+	///	@brief	Gets the root of the parsed nodes.
+	///	@return		The root. It is updated in place by edits.
+	auto const& root() const noexcept { return root_; }
+	///	@brief	Gets the count of the lines.
+	///	@return		The count of the lines including empty ones.
+	std::size_t lines() const noexcept { return lines_.size(); }
+	///	@brief	Gets the whole source.
+	///	@return		Lines joined by new lines.
+	std::string source() const {
+		std::string out;
+		for (auto const& a: lines_) {
+			if (&a != &lines_.front()) out += '\n';
+			out += *a;
+		}
+		return out;
+	}
+	///	@brief	Translates the document to HTML string.
+	///	@param[in]	variables	Variables.
+	///	@param[in]	options		Rendering options.
+	///	@return		String of generated HTML.
+	std::string render(variables_t const& variables = variables_t{}, options_t const& options = options_t{}) const {
+		auto const [out, ctx] = impl::parse_line(impl::context_t{variables, options}, root_, path_);
+		return out;
+	}
+	///	@brief	Replaces the lines.
+	///		The document is not modified if it throws an exception.
+	///	@param[in]	first	Index of the first line to replace, from 0.
+	///	@param[in]	count	Count of the lines to replace.
+	///	@param[in]	text	Lines replacing them. A new line at its end is ignored, and empty text removes the lines.
+	///	@throws		std::out_of_range			It throws the exception if the lines are out of the document.
+	///	@throws		xxx::pug::ex::syntax_error	It throws the exception if the edited document is invalid.
+	void edit(std::size_t first, std::size_t count, std::string_view text) {
+		if (lines_.size() < first || lines_.size() - first < count) throw std::out_of_range(__func__);
+		auto		added = text.empty() ? decltype(lines_){} : split(text.ends_with('\n') ? text.substr(0u, text.size() - 1u) : text);
+		auto const	total = lines_.size() - count + added.size();
+		auto const	at	  = [&](std::size_t i) -> std::string const& { return i < first ? *lines_[i] : i < first + added.size() ? *added[i - first] : *lines_[i - added.size() + count]; };
+		// The line ending the document is parsed again if it is no longer the end, because it keeps the carriage return.
+		auto const	begin = first + count == lines_.size() && first != 0u ? first - 1u : first;
+
+		// The node appended before the edited lines and its ancestors are the state of parsing.
+		// Their children appended after it are detached, and some of them are attached again later.
+		auto previous = root_;
+		for (auto i = begin; 0u < i; --i) {
+			if (nodes_[i - 1u]) {
+				previous = nodes_[i - 1u];
+				break;
+			}
+		}
+		std::vector<chain_t> chain;
+		for (std::shared_ptr<impl::line_node_t> node = previous, child; node; child = node, node = node->parent()) {
+			auto const& children = node->mutable_children();
+			chain.push_back({node, child ? static_cast<std::size_t>(std::ranges::find(children, child) - children.begin()) + 1u : 0u, {}, node->folding(), 0u});
+		}
+
+		// Parses the lines until an unchanged line is appended to the same node as before.
+		std::vector<std::shared_ptr<impl::line_node_t>>	   nodes;
+		std::vector<impl::line_node_t const*>			   folds;
+		std::optional<std::pair<std::size_t, std::size_t>> attached;	// Indices of the chain and the tail attached again.
+		std::size_t										   detached = 0u, line = begin;
+		try {
+			for (; detached < chain.size(); ++detached) chain[detached].tail = chain[detached].node->detach_children(chain[detached].kept);
+			for (; line < total; ++line) {
+				auto const a = get_line(at(line), line + 1u == total);
+				if (! a) {
+					nodes.emplace_back();
+					folds.push_back(nullptr);
+					continue;
+				}
+				auto const folding = a->second.starts_with(impl::def::folding_sv);
+				if (first + added.size() <= line && ! folding) {
+					if (attached = find_tail(chain, previous, *a, nodes_[line - added.size() + count]); attached) break;
+				}
+				folds.push_back(folding ? (previous->parent() ? previous->parent() : previous).get() : nullptr);
+				auto const next = impl::push_line(previous, *a);
+				nodes.push_back(next != previous ? next : nullptr);
+				previous = next;
+			}
+		} catch (...) {
+			for (auto& a: chain | std::views::take(detached)) {
+				(void)a.node->detach_children(a.kept);
+				a.node->attach_children(a.tail);
+				a.node->set_folding(a.folding);
+			}
+			throw;
+		}
+
+		// Attaches the tails again. Tails of the nodes below the one appended the line are parsed again.
+		for (std::size_t i = 0u; i < chain.size(); ++i) {
+			auto& a	   = chain[i];
+			a.appended = a.node->mutable_children().size() - a.kept;
+			if (attached && attached->first <= i) a.node->attach_children(std::span{a.tail}.subspan(i == attached->first ? attached->second : 0u));
+		}
+		auto const end = attached ? line - added.size() + count : lines_.size();	// The end of the old lines parsed again.
+		for (auto i = begin; i < end; ++i) {
+			if (auto const itr = folded_.find(folds_[i]); itr != folded_.end() && --itr->second == 0u) folded_.erase(itr);
+		}
+		std::ranges::for_each(folds, [this](auto const* a) { if (a) ++folded_[a]; });
+		std::ranges::for_each(chain, [this](auto const& a) { a.node->set_folding(folded_.contains(a.node.get())); });
+
+		// Commits the lines.
+		nodes_.erase(nodes_.cbegin() + static_cast<std::ptrdiff_t>(begin), nodes_.cbegin() + static_cast<std::ptrdiff_t>(end));
+		nodes_.insert(nodes_.cbegin() + static_cast<std::ptrdiff_t>(begin), nodes.cbegin(), nodes.cend());
+		folds_.erase(folds_.cbegin() + static_cast<std::ptrdiff_t>(begin), folds_.cbegin() + static_cast<std::ptrdiff_t>(end));
+		folds_.insert(folds_.cbegin() + static_cast<std::ptrdiff_t>(begin), folds.cbegin(), folds.cend());
+		auto const itr = lines_.erase(lines_.cbegin() + static_cast<std::ptrdiff_t>(first), lines_.cbegin() + static_cast<std::ptrdiff_t>(first + count));
+		lines_.insert(itr, std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+
+		// Links conditional chains of the appended nodes, and around them.
+		// The enclosing nodes are marked from the innermost after the appended ones.
+		for (auto const& a: chain) {
+			auto const& children = a.node->mutable_children();
+			std::for_each(children.begin() + static_cast<std::ptrdiff_t>(a.kept), children.begin() + static_cast<std::ptrdiff_t>(a.kept + a.appended), [](auto const& c) {
+				impl::link_conditionals(*c);
+				impl::link_independence(*c);
+			});
+			link(children, a.kept, a.appended);
+			impl::mark_independent(*a.node);
+		}
+	}
+
+	///	@brief	Constructor.
+	///	@param[in]	pug		Source string formatted in pug.
+	///	@param[in]	path	Path of the pug, from which included files are resolved.
+	///	@throws		xxx::pug::ex::syntax_error	It throws the exception if the source is invalid.
+	explicit document_t(std::string_view pug, std::filesystem::path const& path = "./") :
+		lines_{split(pug)}, nodes_(lines_.size()), folds_(lines_.size()), folded_{}, root_{std::make_shared<impl::line_node_t>(impl::line_t{}, nullptr)}, path_{path} {
+		edit(0u, 0u, std::string_view{});	 // It parses all the lines.
+	}
+	document_t(document_t const&)			 = delete;
+	document_t& operator=(document_t const&) = delete;
+
+private:
+	///	@brief	Node enclosing the edited lines.
+	struct chain_t {
+		std::shared_ptr<impl::line_node_t>				node;		 ///< @brief	The node.
+		std::size_t										kept;		 ///< @brief	Count of the children appended before the edited lines.
+		std::vector<std::shared_ptr<impl::line_node_t>> tail;		 ///< @brief	Children appended after them, which are detached.
+		bool											folding;	 ///< @brief	Whether the node was folding or not.
+		std::size_t										appended;	 ///< @brief	Count of the children appended by parsing again.
+	};
+
+	///	@brief	Splits the @p s into lines without new lines.
+	///	@param[in]	s	String to split.
+	///	@return		Lines. The last one is empty if the @p s ends with a new line.
+	static std::vector<std::unique_ptr<std::string const>> split(std::string_view s) {
+		std::vector<std::unique_ptr<std::string const>> lines;
+		for (auto pos = s.find('\n'); pos != std::string_view::npos; pos = s.find('\n')) {
+			lines.push_back(std::make_unique<std::string const>(s.substr(0u, pos)));
+			s.remove_prefix(pos + 1u);
+		}
+		lines.push_back(std::make_unique<std::string const>(s));
+		return lines;
+	}
+	///	@brief	Gets the nested line as the parse_file() does.
+	///	@param[in]	s		A raw line without the new line.
+	///	@param[in]	last	Whether the line ends the document or not.
+	///	@return		The nested line. It is null if the line is ignored.
+	static std::optional<impl::line_t> get_line(std::string_view s, bool last) {
+		if (! last && s.ends_with('\r')) s.remove_suffix(1u);
+		return s.empty() ? std::nullopt : std::make_optional(impl::get_line_nest(s));
+	}
+	///	@brief	Finds the detached tail beginning from the @p node if the @p a line is appended to the same node as before.
+	///	@param[in]	chain		Nodes enclosing the edited lines.
+	///	@param[in]	previous	The line appended previously.
+	///	@param[in]	a			An unchanged line.
+	///	@param[in]	node		The node appended by the @p a line before. It is null if the line was dropped.
+	///	@return		Indices of the @p chain and its tail. It returns null if the line is appended to another node.
+	static std::optional<std::pair<std::size_t, std::size_t>> find_tail(std::vector<chain_t> const& chain, std::shared_ptr<impl::line_node_t> const& previous, impl::line_t const& a, std::shared_ptr<impl::line_node_t> const& node) {
+		if (! node) return std::nullopt;
+		auto const [parent, line] = impl::locate_line(previous, a);
+		if (! parent || parent != node->parent() || line.first != node->nest()) return std::nullopt;
+		auto const itr = std::ranges::find(chain, parent, &chain_t::node);
+		if (itr == chain.cend()) return std::nullopt;
+		auto const tail = std::ranges::find(itr->tail, node);
+		if (tail == itr->tail.cend()) return std::nullopt;
+		return std::make_pair(static_cast<std::size_t>(itr - chain.cbegin()), static_cast<std::size_t>(tail - itr->tail.cbegin()));
+	}
+	///	@brief	Links conditional chains of the @p children around the appended ones.
+	///	@param[in]	children	Children of a node enclosing the edited lines.
+	///	@param[in]	first		Index of the first appended child.
+	///	@param[in]	count		Count of the appended children.
+	static void link(std::span<std::shared_ptr<impl::line_node_t> const> children, std::size_t first, std::size_t count) {
+		auto begin = first;
+		if (0u < begin) --begin;
+		while (0u < begin && children[begin]->chained()) --begin;	 // The 'if' line of the chain.
+		auto end = std::min(first + count, children.size());
+		while (end < children.size() && std::ranges::any_of(std::initializer_list<std::regex const*>{&impl::def::elif_re, &impl::def::else_re}, [&s = children[end]->line()](auto const* re) { return std::regex_match(s.cbegin(), s.cend(), *re); })) {
+			++end;
+		}
+		std::for_each(children.begin() + static_cast<std::ptrdiff_t>(begin), children.begin() + static_cast<std::ptrdiff_t>(end), [](auto const& a) { a->set_chained(false); });
+		impl::link_chains(children.subspan(begin, end - begin));
+	}
+
+	std::vector<std::unique_ptr<std::string const>>				  lines_;	  ///< @brief	Lines without new lines. Nodes refer views of them.
+	std::vector<std::shared_ptr<impl::line_node_t>>				  nodes_;	  ///< @brief	Nodes appended by the lines. It is null if the line is dropped.
+	std::vector<impl::line_node_t const*>						  folds_;	  ///< @brief	Nodes made folding by the lines.
+	std::unordered_map<impl::line_node_t const*, std::size_t>	  folded_;	  ///< @brief	Counts of the lines making the nodes folding.
+	std::shared_ptr<impl::line_node_t>							  root_;	  ///< @brief	The root of the parsed nodes.
+	std::filesystem::path										  path_;	  ///< @brief	Path of the pug.
+};
+
 }	 // namespace xxx::pug
 
 #endif	  // xxx_PUG_HPP_
@@ -0,0 +1,284 @@
+///	@file
+///	@brief		pug++  - Content-addressed render cache on disk
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	Rendered files are cached by the hashes of all the inputs, so that unchanged pages are copied instead of rendered.
+///	Included files are known only after rendering, so that a lookup has two steps:
+///		-#	The manifest is found by the hash of the version, options, variables, and the path and the source of the pug file.
+///			Included files are resolved from the path, so that the same source in another directory has another manifest.
+///			It lists the included and extended files with the hashes of their contents.
+///		-#	If every listed file has the same hash, the rendered files are found by the hash of the manifest.
+
+#ifndef xxx_PUG_CACHE_HPP_
+#define xxx_PUG_CACHE_HPP_
+
+#include "pug.hpp"
+#include <array>
+#include <cstdint>
+#include <map>
+
+namespace xxx::pug::cache {
+namespace def {
+static std::string_view const manifest_sv{".manifest"};
+static std::string_view const temporary_sv{".tmp"};
+}	 // namespace def
+
+namespace impl {
+
+///	@brief	SHA-256 hash function.
+class sha256_t {
+public:
+	using digest_t = std::array<std::uint8_t, 32u>;	   ///< @brief	Digest.
+
+	///	@brief	Updates the hash with the @p data.
+	///	@param[in]	data	Data.
+	///	@return		This object.
+	sha256_t& update(std::string_view data) {
+		size_ += data.size();
+		for (auto const c: data) {
+			block_[filled_++] = static_cast<std::uint8_t>(c);
+			if (filled_ == block_.size()) {
+				transform();
+				filled_ = 0u;
+			}
+		}
+		return *this;
+	}
+	///	@brief	Updates the hash with the @p data prefixed by its size.
+	///		It keeps boundaries between fields, so that ("ab", "c") differs from ("a", "bc").
+	///	@param[in]	data	Data.
+	///	@return		This object.
+	sha256_t& field(std::string_view data) { return update(std::to_string(data.size()) + ':').update(data); }
+	///	@brief	Finishes the hash.
+	///	@return		Digest.
+	digest_t finish() {
+		auto const bits = static_cast<std::uint64_t>(size_) * 8u;
+		update(std::string_view{"\x80", 1u});
+		while (filled_ != 56u) update(std::string_view{"\0", 1u});
+		for (int i = 7; 0 <= i; --i) {
+			block_[filled_++] = static_cast<std::uint8_t>(bits >> (i * 8));
+		}
+		transform();
+
+		digest_t digest{};
+		for (std::size_t i = 0u; i < state_.size(); ++i) {
+			for (std::size_t j = 0u; j < 4u; ++j) {
+				digest[i * 4u + j] = static_cast<std::uint8_t>(state_[i] >> (24u - j * 8u));
+			}
+		}
+		return digest;
+	}
+
+private:
+	///	@brief	Rotates the @p x right.
+	static constexpr std::uint32_t rotr(std::uint32_t x, int n) noexcept { return (x >> n) | (x << (32 - n)); }
+
+	///	@brief	Transforms the state by the current block.
+	void transform() noexcept {
+		static constexpr std::array<std::uint32_t, 64u> k{
+			0x428a2f98u, 0x71374491u, 0xb5c0fbcfu, 0xe9b5dba5u, 0x3956c25bu, 0x59f111f1u, 0x923f82a4u, 0xab1c5ed5u,
+			0xd807aa98u, 0x12835b01u, 0x243185beu, 0x550c7dc3u, 0x72be5d74u, 0x80deb1feu, 0x9bdc06a7u, 0xc19bf174u,
+			0xe49b69c1u, 0xefbe4786u, 0x0fc19dc6u, 0x240ca1ccu, 0x2de92c6fu, 0x4a7484aau, 0x5cb0a9dcu, 0x76f988dau,
+			0x983e5152u, 0xa831c66du, 0xb00327c8u, 0xbf597fc7u, 0xc6e00bf3u, 0xd5a79147u, 0x06ca6351u, 0x14292967u,
+			0x27b70a85u, 0x2e1b2138u, 0x4d2c6dfcu, 0x53380d13u, 0x650a7354u, 0x766a0abbu, 0x81c2c92eu, 0x92722c85u,
+			0xa2bfe8a1u, 0xa81a664bu, 0xc24b8b70u, 0xc76c51a3u, 0xd192e819u, 0xd6990624u, 0xf40e3585u, 0x106aa070u,
+			0x19a4c116u, 0x1e376c08u, 0x2748774cu, 0x34b0bcb5u, 0x391c0cb3u, 0x4ed8aa4au, 0x5b9cca4fu, 0x682e6ff3u,
+			0x748f82eeu, 0x78a5636fu, 0x84c87814u, 0x8cc70208u, 0x90befffau, 0xa4506cebu, 0xbef9a3f7u, 0xc67178f2u};
+
+		std::array<std::uint32_t, 64u> w{};
+		for (std::size_t i = 0u; i < 16u; ++i) {
+			w[i] = (std::uint32_t{block_[i * 4u]} << 24) | (std::uint32_t{block_[i * 4u + 1u]} << 16) | (std::uint32_t{block_[i * 4u + 2u]} << 8) | std::uint32_t{block_[i * 4u + 3u]};
+		}
+		for (std::size_t i = 16u; i < 64u; ++i) {
+			auto const s0 = rotr(w[i - 15u], 7) ^ rotr(w[i - 15u], 18) ^ (w[i - 15u] >> 3);
+			auto const s1 = rotr(w[i - 2u], 17) ^ rotr(w[i - 2u], 19) ^ (w[i - 2u] >> 10);
+			w[i]		  = w[i - 16u] + s0 + w[i - 7u] + s1;
+		}
+
+		auto [a, b, c, d, e, f, g, h] = state_;
+		for (std::size_t i = 0u; i < 64u; ++i) {
+			auto const t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+			auto const t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+			h			  = g;
+			g			  = f;
+			f			  = e;
+			e			  = d + t1;
+			d			  = c;
+			c			  = b;
+			b			  = a;
+			a			  = t1 + t2;
+		}
+		std::array<std::uint32_t, 8u> const v{a, b, c, d, e, f, g, h};
+		std::ranges::transform(state_, v, state_.begin(), std::plus<>{});
+	}
+
+	std::array<std::uint32_t, 8u> state_{0x6a09e667u, 0xbb67ae85u, 0x3c6ef372u, 0xa54ff53au, 0x510e527fu, 0x9b05688cu, 0x1f83d9abu, 0x5be0cd19u};	 ///< @brief	State.
+	std::array<std::uint8_t, 64u> block_{};		 ///< @brief	Current block.
+	std::size_t					  filled_{};	 ///< @brief	Size filled in the current block.
+	std::size_t					  size_{};		 ///< @brief	Total size of the data.
+};
+
+///	@brief	Formats the @p digest in hexadecimal.
+///	@param[in]	digest	Digest.
+///	@return		Hexadecimal string.
+inline std::string to_hex(sha256_t::digest_t const& digest) {
+	std::string out;
+	out.reserve(digest.size() * 2u);
+	for (auto const b: digest) {
+		out += "0123456789abcdef"[b >> 4];
+		out += "0123456789abcdef"[b & 0x0Fu];
+	}
+	return out;
+}
+
+///	@brief	Gets the hash of the contents of the file.
+///	@param[in]	path	Path of the file.
+///	@return		Hexadecimal hash.
+///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+inline std::string hash_file(std::filesystem::path const& path) {
+	return to_hex(sha256_t{}.update(pug::impl::load_file(path)).finish());
+}
+
+///	@brief	Writes the file atomically.
+///		It writes a temporary file and renames it, so that concurrent builds never read partial files.
+///	@tparam		F		Type of the @p write.
+///	@param[in]	path	Path of the file.
+///	@param[in]	write	Function to write the temporary file of the path given.
+///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+template<typename F>
+inline void write_file(std::filesystem::path const& path, F const& write) {
+	auto temporary = path;
+	temporary += def::temporary_sv;
+	try {
+		write(temporary);
+		std::filesystem::rename(temporary, path);
+	} catch (std::ios_base::failure const& e) {
+		std::error_code ec;
+		std::filesystem::remove(temporary, ec);
+		throw ex::io_error(path, e.code());
+	} catch (std::filesystem::filesystem_error const& e) {
+		std::error_code ec;
+		std::filesystem::remove(temporary, ec);
+		throw ex::io_error(path, e.code());
+	}
+}
+
+}	 // namespace impl
+
+///	@brief	Content-addressed cache of rendered files on disk.
+///		It is shared by invocations through the directory.
+class disk_cache_t {
+public:
+	///	@brief	Entry of the cache.
+	struct entry_t {
+		std::vector<std::filesystem::path> files;			///< @brief	Cached files by their suffixes; e.g., '.html' and '.html.gz'.
+		std::vector<std::filesystem::path> dependencies;	///< @brief	Files read by include and extends.
+	};
+
+	///	@brief	Gets the key of the manifest.
+	///	@param[in]	path		Path of the pug file, which resolves the included files.
+	///	@param[in]	source		Source of the pug file.
+	///	@param[in]	variables	Variables.
+	///	@param[in]	salt		Other inputs that affect outputs; e.g., options.
+	///	@return		Key of the manifest.
+	static std::string key(std::filesystem::path const& path, std::string_view source, variables_t const& variables, std::string_view salt) {
+		// Symbolic links are not resolved because included files are resolved from the link.
+		impl::sha256_t hash;
+		hash.field(version).field(salt).field(std::filesystem::absolute(path).lexically_normal().string()).field(source);
+		for (std::map<std::string_view, std::string_view> const sorted(variables.cbegin(), variables.cend()); auto const& [name, value]: sorted) {
+			hash.field(name).field(value);
+		}
+		return impl::to_hex(hash.finish());
+	}
+
+	///	@brief	Finds the entry of the @p key.
+	///		The entry is valid only if the included files are not modified.
+	///	@param[in]	key			Key of the manifest.
+	///	@param[in]	suffixes	Suffixes of the files required.
+	///	@return		The entry. It returns null if it is not cached.
+	std::optional<entry_t> find(std::string const& key, std::vector<std::string> const& suffixes) {
+		try {
+			auto const manifest = path(key) += def::manifest_sv;
+			if (! std::filesystem::exists(manifest)) return miss();
+
+			// Each line is a hash and a path of a dependency.
+			entry_t			  entry;
+			std::string const content = pug::impl::load_file(manifest);
+			for (auto const line: pug::impl::split_lines(content)) {
+				auto const pos = line.find(' ');
+				if (pos == std::string_view::npos) return miss();
+				std::filesystem::path dependency{line.substr(pos + 1u)};
+				if (! std::filesystem::exists(dependency) || impl::hash_file(dependency) != line.substr(0u, pos)) return miss();
+				entry.dependencies.push_back(std::move(dependency));
+			}
+			auto const result = path(impl::to_hex(impl::sha256_t{}.field(key).field(content).finish()));
+			for (auto const& suffix: suffixes) {
+				auto file = std::filesystem::path{result} += suffix;
+				if (! std::filesystem::exists(file)) return miss();
+				entry.files.push_back(std::move(file));
+			}
+			++hits_;
+			return entry;
+		} catch (std::exception const&) {
+			return miss();	  // Broken entry is dealt as missing.
+		}
+	}
+	///	@brief	Stores the rendered files.
+	///	@param[in]	key				Key of the manifest.
+	///	@param[in]	files			Rendered files by their suffixes.
+	///	@param[in]	dependencies	Files read by include and extends.
+	///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+	void store(std::string const& key, std::vector<std::pair<std::string, std::filesystem::path>> const& files, std::vector<std::filesystem::path> const& dependencies) {
+		std::string			  content;
+		std::set<std::string> written;
+		for (auto const& a: dependencies) {
+			auto const dependency = std::filesystem::absolute(a).lexically_normal().string();
+			if (written.insert(dependency).second) content += impl::hash_file(dependency) + ' ' + dependency + '\n';
+		}
+		auto const result = path(impl::to_hex(impl::sha256_t{}.field(key).field(content).finish()));
+		std::filesystem::create_directories(result.parent_path());
+		for (auto const& [suffix, file]: files) {
+			impl::write_file(std::filesystem::path{result} += suffix, [&file](auto const& temporary) { std::filesystem::copy_file(file, temporary, std::filesystem::copy_options::overwrite_existing); });
+		}
+		// The manifest is written at last, so that it refers only complete files.
+		auto manifest = path(key);
+		std::filesystem::create_directories(manifest.parent_path());
+		impl::write_file(manifest += def::manifest_sv, [&content](auto const& temporary) {
+			std::ofstream ofs;
+			ofs.exceptions(std::ios::badbit | std::ios::failbit);
+			ofs.open(temporary, std::ios::out | std::ios::binary);
+			ofs << content;
+		});
+	}
+
+	///	@brief	Gets the count of the cache hits.
+	///	@return		The count of the cache hits.
+	std::size_t hits() const noexcept { return hits_; }
+	///	@brief	Gets the count of the cache misses.
+	///	@return		The count of the cache misses.
+	std::size_t misses() const noexcept { return misses_; }
+
+	///	@brief	Constructor.
+	///	@param[in]	directory	Directory of the cache.
+	explicit disk_cache_t(std::filesystem::path directory) :
+		directory_{std::move(directory)}, hits_{}, misses_{} {}
+
+private:
+	///	@brief	Gets the path of the @p key without suffix.
+	///		Files are distributed to sub-directories by the first two digits.
+	std::filesystem::path path(std::string const& key) const { return directory_ / key.substr(0u, 2u) / key.substr(2u); }
+	///	@brief	Counts a miss.
+	std::optional<entry_t> miss() noexcept {
+		++misses_;
+		return std::nullopt;
+	}
+
+	std::filesystem::path directory_;	 ///< @brief	Directory of the cache.
+	std::size_t			  hits_;		 ///< @brief	Count of the cache hits.
+	std::size_t			  misses_;		 ///< @brief	Count of the cache misses.
+};
+
+}	 // namespace xxx::pug::cache
+
+#endif	  // xxx_PUG_CACHE_HPP_
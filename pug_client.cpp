@@ -0,0 +1,116 @@
+///	@file
+///	@brief		pug++  - Client and load test of the render daemon
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+
+#include "pug_serve.hpp"
+#include <charconv>
+#include <chrono>
+#include <optional>
+
+namespace {
+
+///	@brief	Gets a usage string of this program.
+///	@return		A usage string of this program.
+inline std::string get_usage() {
+	return "===[ pug-client ]===  (c) 2022-, Mura.\n"
+		   "\n"
+		   "[USAGE] $ pug-client  (options)  {socket}  {pug file}  ({JSON file})\n"
+		   "  It requests the daemon ('pug --serve') to translate the pug file and prints the HTML.\n"
+		   "[options]\n"
+		   "  -h                  : shows this usage only\n"
+		   "  --repeat=count      : requests count times and prints latencies instead of the HTML\n"
+		   "  --concurrency=count : count of concurrent clients while repeating\n";
+}
+
+///	@brief	Gets the count of the option formed as '--name=count'.
+///	@param[in]	arguments	All the arguments.
+///	@param[in]	name		Name of the option including the '--' indicator and the '='.
+///	@return		It returns the count; otherwise, it returns null if the option is not specified or invalid.
+inline std::optional<std::size_t> get_count(std::vector<std::string_view> const& arguments, std::string_view name) {
+	for (auto const& a: arguments) {
+		if (! a.starts_with(name)) continue;
+		std::size_t count{};
+		if (auto const [p, ec] = std::from_chars(a.data() + name.size(), a.data() + a.size(), count); ec == std::errc{} && p == a.data() + a.size() && 0u < count) {
+			return count;
+		}
+	}
+	return std::nullopt;
+}
+
+///	@brief	Requests repeatedly and prints the statistics of latencies.
+///	@param[in]	socket		Path of the socket.
+///	@param[in]	path		Path of the pug file.
+///	@param[in]	json		Variables formatted as JSON.
+///	@param[in]	repeat		Count of requests.
+///	@param[in]	concurrency	Count of concurrent clients.
+inline void load_test(std::filesystem::path const& socket, std::filesystem::path const& path, std::string_view json, std::size_t repeat, std::size_t concurrency) {
+	using clock_t = std::chrono::steady_clock;
+	std::vector<std::chrono::nanoseconds> latencies(repeat);
+	std::atomic<std::size_t>			  next{0u};
+	std::atomic<std::size_t>			  failures{0u};
+
+	auto const begin = clock_t::now();
+	{
+		std::vector<std::jthread> clients;
+		std::generate_n(std::back_inserter(clients), std::min(repeat, concurrency), [&] {
+			return std::jthread{[&] {
+				for (auto i = next++; i < repeat; i = next++) {
+					auto const start = clock_t::now();
+					try {
+						(void)xxx::pug::serve::request(socket, path, json);
+					} catch (std::exception const&) {
+						++failures;
+					}
+					latencies[i] = clock_t::now() - start;
+				}
+			}};
+		});
+	}	 // Joins all the clients.
+	auto const elapsed = std::chrono::duration<double>(clock_t::now() - begin).count();
+
+	std::ranges::sort(latencies);
+	auto const percentile = [&latencies](std::size_t p) {
+		return std::chrono::duration<double, std::micro>(latencies[std::min(latencies.size() - 1u, latencies.size() * p / 100u)]).count();
+	};
+	std::cout << "requests    : " << repeat << " (failures: " << failures << ")\n"
+			  << "concurrency : " << concurrency << '\n'
+			  << "throughput  : " << static_cast<double>(repeat) / elapsed << " req/s\n"
+			  << "latency p50 : " << percentile(50u) << " us\n"
+			  << "latency p99 : " << percentile(99u) << " us\n";
+}
+
+}	 // namespace
+
+///	@brief	Main entry of this program.
+///	@param[in]	ac	Argument count.
+///	@param[in]	av	Argument values.
+///	@return		It returns zero if the program finished requests; otherwise,
+///				it returns a negative value if the program failed; otherwise,
+///				it returns a positive value if the program shows usage only.
+int main(int ac, char* av[]) {
+	try {
+		std::ios::sync_with_stdio(false);
+
+		std::vector<std::string_view> const args(av + 1, av + ac);
+		auto								paths = args | std::views::filter([](auto const& a) { return ! a.starts_with('-'); }) | std::views::common;
+		std::vector<std::string_view> const arguments(paths.begin(), paths.end());
+		if (std::ranges::find(args, "-h") != args.cend() || arguments.size() < 2u || 3u < arguments.size()) {
+			std::clog << get_usage();
+			return 1;
+		}
+
+		std::filesystem::path const socket{arguments[0]};
+		auto const					path = std::filesystem::absolute(arguments[1]);	   // The daemon resolves it from its own directory.
+		auto const					json = arguments.size() < 3u ? std::string{} : xxx::pug::impl::load_file(arguments[2]);
+		if (auto const repeat = get_count(args, "--repeat="); repeat) {
+			load_test(socket, path, json, *repeat, get_count(args, "--concurrency=").value_or(1u));
+		} else {
+			std::cout << xxx::pug::serve::request(socket, path, json);
+		}
+		return 0;
+	} catch (std::exception const& e) {
+		std::cerr << e.what() << std::endl;
+	}
+	return -1;
+}
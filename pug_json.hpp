@@ -0,0 +1,187 @@
+///	@file
+///	@brief		pug++  - Variables from JSON
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+
+#ifndef xxx_PUG_JSON_HPP_
+#define xxx_PUG_JSON_HPP_
+
+#include "pug.hpp"
+#include <deque>
+#include <optional>
+
+namespace xxx::pug::json {
+
+///	@brief	Variables read from JSON.
+///		Names of the variables_t are views, so that it keeps the names available.
+///		Moving it keeps the views available too.
+struct document_t {
+	std::deque<std::string> names;		  ///< @brief	Names of the variables.
+	variables_t				variables;	  ///< @brief	Variables.
+};
+
+namespace impl {
+
+///	@brief	Skips whitespaces.
+///	@param[in]	s	JSON string.
+///	@return		Remaining string.
+inline std::string_view skip(std::string_view s) noexcept {
+	auto const pos = s.find_first_not_of(" \t\r\n");
+	return pos == std::string_view::npos ? std::string_view{} : s.substr(pos);
+}
+
+///	@brief	Appends a code point formatted in UTF-8.
+///	@param[in,out]	out		Output string.
+///	@param[in]		cp		Code point.
+inline void append_utf8(std::string& out, char32_t cp) {
+	if (cp < 0x80u) {
+		out += static_cast<char>(cp);
+	} else if (cp < 0x800u) {
+		out += static_cast<char>(0xC0u | (cp >> 6));
+		out += static_cast<char>(0x80u | (cp & 0x3Fu));
+	} else if (cp < 0x10000u) {
+		out += static_cast<char>(0xE0u | (cp >> 12));
+		out += static_cast<char>(0x80u | ((cp >> 6) & 0x3Fu));
+		out += static_cast<char>(0x80u | (cp & 0x3Fu));
+	} else {
+		out += static_cast<char>(0xF0u | (cp >> 18));
+		out += static_cast<char>(0x80u | ((cp >> 12) & 0x3Fu));
+		out += static_cast<char>(0x80u | ((cp >> 6) & 0x3Fu));
+		out += static_cast<char>(0x80u | (cp & 0x3Fu));
+	}
+}
+
+///	@brief	Reads four hexadecimal digits of the '\\u' escape sequence.
+///	@param[in]	s	JSON string just after the 'u'.
+///	@return		Code unit of UTF-16.
+///	@throws		xxx::pug::ex::syntax_error	It throws the exception if the digits are invalid.
+inline char32_t parse_hex4(std::string_view s) {
+	if (s.size() < 4u) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+	char32_t v{};
+	for (auto const c: s.substr(0, 4u)) {
+		v <<= 4;
+		if ('0' <= c && c <= '9')
+			v |= static_cast<char32_t>(c - '0');
+		else if ('a' <= c && c <= 'f')
+			v |= static_cast<char32_t>(c - 'a' + 10);
+		else if ('A' <= c && c <= 'F')
+			v |= static_cast<char32_t>(c - 'A' + 10);
+		else
+			throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+	}
+	return v;
+}
+
+///	@brief	Parses a JSON string.
+///	@param[in]	s	JSON string starting with the '"'.
+///	@return		It returns the followings:
+///		-#	Unescaped string.
+///		-#	Remaining string.
+///	@throws		xxx::pug::ex::syntax_error	It throws the exception if the string is invalid.
+inline std::tuple<std::string, std::string_view> parse_string(std::string_view s) {
+	if (! s.starts_with('"')) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+	s = s.substr(1);
+
+	std::string out;
+	for (auto pos = s.find_first_of("\"\\"); pos != std::string_view::npos; pos = s.find_first_of("\"\\")) {
+		out += s.substr(0, pos);
+		if (s[pos] == '"') return {out, s.substr(pos + 1)};
+		if (s.size() <= pos + 1) break;
+		switch (auto const c = s[pos + 1]; c) {
+		case '"': out += '"'; break;
+		case '\\': out += '\\'; break;
+		case '/': out += '/'; break;
+		case 'b': out += '\b'; break;
+		case 'f': out += '\f'; break;
+		case 'n': out += '\n'; break;
+		case 'r': out += '\r'; break;
+		case 't': out += '\t'; break;
+		case 'u': {
+			auto cp = parse_hex4(s.substr(pos + 2));
+			if (0xD800u <= cp && cp < 0xDC00u) {
+				// Surrogate pair.
+				if (s.substr(pos + 6, 2) != "\\u") throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+				auto const low = parse_hex4(s.substr(pos + 8));
+				if (low < 0xDC00u || 0xE000u <= low) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+				cp = 0x10000u + ((cp - 0xD800u) << 10) + (low - 0xDC00u);
+				pos += 6;
+			}
+			append_utf8(out, cp);
+			pos += 4;
+			break;
+		}
+		default:
+			throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+		}
+		s = s.substr(pos + 2);
+	}
+	throw ex::syntax_error(__func__ + std::to_string(__LINE__));	// Unterminated.
+}
+
+///	@brief	Parses a JSON value as a value of variable.
+///		Numbers are kept as they are written. Nested objects and arrays are not supported.
+///	@param[in]	s	JSON string starting with the value.
+///	@return		It returns the followings:
+///		-#	Value. Null means the 'null' value.
+///		-#	Remaining string.
+///	@throws		xxx::pug::ex::syntax_error	It throws the exception if the value is invalid.
+inline std::tuple<std::optional<std::string>, std::string_view> parse_value(std::string_view s) {
+	using namespace std::string_view_literals;
+	if (s.starts_with('"')) {
+		auto [v, rest] = parse_string(s);
+		return {std::move(v), rest};
+	}
+	for (auto const literal: {"true"sv, "false"sv}) {
+		if (s.starts_with(literal)) return {std::string{literal}, s.substr(literal.size())};
+	}
+	if (s.starts_with("null"sv)) return {std::nullopt, s.substr(4u)};
+
+	auto const end = s.find_first_not_of("+-.0123456789eE");
+	auto const v   = s.substr(0, end);
+	if (v.empty() || v.back() == '-' || v.back() == '.') throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+	return {std::string{v}, end == std::string_view::npos ? std::string_view{} : s.substr(end)};
+}
+
+}	 // namespace impl
+
+///	@brief	Parses a flat JSON object as variables.
+///		Each member becomes a variable. Members of the 'null' value are omitted.
+///		Blank string is dealt as an empty object.
+///	@param[in]	json	JSON string formatted as an object.
+///	@return		Variables.
+///	@throws		xxx::pug::ex::syntax_error	It throws the exception if the JSON is invalid or not flat.
+inline document_t parse_object(std::string_view json) {
+	document_t doc;
+	auto	   s = impl::skip(json);
+	if (s.empty()) return doc;
+	if (! s.starts_with('{')) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+	s = impl::skip(s.substr(1));
+	if (s.starts_with('}')) {
+		s = impl::skip(s.substr(1));
+	} else {
+		for (;;) {
+			auto [name, r1] = impl::parse_string(s);
+			s				= impl::skip(r1);
+			if (! s.starts_with(':')) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+			auto [value, r2] = impl::parse_value(impl::skip(s.substr(1)));
+			s				 = impl::skip(r2);
+			if (value && ! name.empty()) {
+				doc.variables[doc.names.emplace_back(std::move(name))] = std::move(*value);
+			}
+			if (s.starts_with(',')) {
+				s = impl::skip(s.substr(1));
+			} else if (s.starts_with('}')) {
+				s = impl::skip(s.substr(1));
+				break;
+			} else {
+				throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+			}
+		}
+	}
+	if (! s.empty()) throw ex::syntax_error(__func__ + std::to_string(__LINE__));
+	return doc;
+}
+
+}	 // namespace xxx::pug::json
+
+#endif	  // xxx_PUG_JSON_HPP_
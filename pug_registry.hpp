@@ -0,0 +1,245 @@
+///	@file
+///	@brief		pug++  - Concurrent registry of compiled templates
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	Compiled templates are published as immutable snapshots, which is read-copy-update:
+///		-#	A reader looks up the snapshot it holds without locks, and it takes a new snapshot only when the version is changed.
+///		-#	A writer compiles a template off to the side, copies the map with it, and publishes the new snapshot atomically.
+///		-#	An old snapshot and its templates are released when the last reader leaves it, so that in-flight renderings keep using them.
+///	Templates beyond the memory budget are evicted in order of their last use.
+///	Identical subtrees of the templates are shared optionally, and the shared nodes no template refers are released at publishing.
+
+#ifndef xxx_PUG_REGISTRY_HPP_
+#define xxx_PUG_REGISTRY_HPP_
+
+#include "pug.hpp"
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+
+namespace xxx::pug::registry {
+namespace impl {
+
+///	@brief	Gets the last write time of the file.
+///	@param[in]	path	Path of the file.
+///	@return		The last write time.
+///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+inline std::filesystem::file_time_type last_write_time(std::filesystem::path const& path) {
+	std::error_code ec;
+	auto const		time = std::filesystem::last_write_time(path, ec);
+	if (ec) throw ex::io_error(path, ec);
+	return time;
+}
+
+///	@brief	Compiled template in the registry.
+struct entry_t {
+	std::filesystem::path				path;		 ///< @brief	Path of the pug file.
+	std::filesystem::file_time_type		time;		 ///< @brief	Last write time of the pug file when it was compiled.
+	std::shared_ptr<interner_t>			interner;	 ///< @brief	Interner of the shared nodes. It outlives the @p compiled.
+	pug::impl::counting_resource_t		resource;	 ///< @brief	Memory resource of the parsed nodes. It outlives the @p compiled.
+	template_t							compiled;	 ///< @brief	Compiled template.
+	std::size_t							size;		 ///< @brief	Resident bytes of the source and the nodes not shared.
+	mutable std::atomic<std::uint64_t>	used;		 ///< @brief	Version of the registry when it was used at last.
+
+	///	@brief	Constructor.
+	///		It compiles the pug file.
+	///	@param[in]	path		Path of the pug file.
+	///	@param[in]	version		Current version of the registry.
+	///	@param[in]	interner	Interner of the shared nodes. It is null not to share them.
+	entry_t(std::filesystem::path const& path, std::uint64_t version, std::shared_ptr<interner_t> interner) :
+		path{path}, time{impl::last_write_time(path)}, interner{std::move(interner)}, resource{}, compiled{pug::impl::load_file(path), path, &resource, this->interner.get()}, size{}, used{version} {
+		size = sizeof(entry_t) + resource.bytes() + compiled.source().size();
+	}
+};
+
+///	@brief	Hash of names, which finds a string by its view.
+struct hash_t {
+	using is_transparent = void;
+	std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+};
+
+///	@brief	Map of compiled templates by their names.
+using map_t = std::unordered_map<std::string, std::shared_ptr<entry_t const>, hash_t, std::equal_to<>>;
+
+}	 // namespace impl
+
+///	@brief	Concurrent registry of compiled templates by their names.
+///		A name is the path of a pug file relative to the base directory.
+class registry_t {
+public:
+	///	@brief	Reader of the registry for a thread.
+	///		It holds a snapshot of the registry, so that lookups neither lock nor modify shared reference counts.
+	///		It must not be shared by threads.
+	class reader_t {
+	public:
+		///	@brief	Gets the compiled template of the @p name.
+		///		It is compiled and published if it is not registered.
+		///	@param[in]	name	Name of the template.
+		///	@return		Compiled template. It is valid until the next call of this reader.
+		///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred, or the name is out of the base directory.
+		///	@throws		xxx::pug::ex::syntax_error	It throws the exception if the template is invalid.
+		template_t const& get(std::string_view name) {
+			if (auto const version = registry_.version_.load(std::memory_order_acquire); version != version_) {
+				snapshot_ = registry_.snapshot_.load();
+				version_  = version;
+			}
+			if (auto const itr = snapshot_->find(name); itr != snapshot_->cend()) {
+				auto const& entry = *itr->second;
+				if (entry.used.load(std::memory_order_relaxed) != version_) entry.used.store(version_, std::memory_order_relaxed);
+				return entry.compiled;
+			}
+			loaded_ = registry_.load(name);	   // It is kept even if it is evicted at once.
+			return loaded_->compiled;
+		}
+		///	@brief	Renders the template of the @p name.
+		///	@param[in]	name		Name of the template.
+		///	@param[in]	variables	Variables.
+		///	@param[in]	options		Rendering options.
+		///	@return		String of generated HTML.
+		std::string render(std::string_view name, variables_t const& variables = variables_t{}, options_t const& options = options_t{}) {
+			return get(name).render(variables, options);
+		}
+
+		///	@brief	Constructor.
+		///	@param[in]	registry	Registry to read.
+		explicit reader_t(registry_t& registry) :
+			registry_{registry}, snapshot_{registry.snapshot_.load()}, version_{registry.version_.load(std::memory_order_acquire)}, loaded_{} {}
+
+	private:
+		registry_t&							  registry_;	///< @brief	Registry to read.
+		std::shared_ptr<impl::map_t const>	  snapshot_;	///< @brief	Snapshot held by this reader.
+		std::uint64_t						  version_;		///< @brief	Version of the snapshot.
+		std::shared_ptr<impl::entry_t const> loaded_;		///< @brief	Template loaded by the last miss.
+	};
+
+	///	@brief	Finds the compiled template of the @p name.
+	///		It is compiled and published if it is not registered.
+	///	@param[in]	name	Name of the template.
+	///	@return		Compiled template. It is kept alive even if it is reloaded or evicted.
+	///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred, or the name is out of the base directory.
+	std::shared_ptr<template_t const> find(std::string_view name) {
+		auto const snapshot = snapshot_.load();
+		auto const itr		= snapshot->find(name);
+		auto const entry	= itr != snapshot->cend() ? itr->second : load(name);
+		entry->used.store(version_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		return std::shared_ptr<template_t const>{entry, &entry->compiled};
+	}
+	///	@brief	Reloads the templates whose files are modified.
+	///		New versions are compiled without blocking readers, and they are published at once.
+	///		Templates whose files are removed or invalid keep their current versions.
+	///	@return		Count of the reloaded templates.
+	std::size_t reload() {
+		std::lock_guard lock{mutex_};
+		auto			map		 = std::make_shared<impl::map_t>(*snapshot_.load());
+		std::size_t		reloaded = 0u;
+		for (auto& [name, entry]: *map) {
+			try {
+				if (impl::last_write_time(entry->path) == entry->time) continue;
+				entry = std::make_shared<impl::entry_t const>(entry->path, version_.load() + 1u, interner_);
+				++reloaded;
+			} catch (std::exception const&) {
+				// The current version is kept.
+			}
+		}
+		if (reloaded) publish(std::move(map), std::string_view{});
+		return reloaded;
+	}
+	///	@brief	Removes the template of the @p name.
+	///	@param[in]	name	Name of the template.
+	void erase(std::string_view name) {
+		std::lock_guard lock{mutex_};
+		auto			map = std::make_shared<impl::map_t>(*snapshot_.load());
+		if (auto const itr = map->find(name); itr != map->cend()) {
+			map->erase(itr);
+			publish(std::move(map), std::string_view{});
+		}
+	}
+
+	///	@brief	Gets the count of the registered templates.
+	///	@return		The count of the templates.
+	std::size_t count() const { return snapshot_.load()->size(); }
+	///	@brief	Gets the resident bytes of the registered templates.
+	///	@return		The resident bytes including the shared nodes.
+	std::size_t size() const { return size_.load() + shared(); }
+	///	@brief	Gets the resident bytes of the nodes shared by the templates.
+	///	@return		The resident bytes. It is zero if the nodes are not shared.
+	std::size_t shared() const noexcept { return interner_ ? interner_->size() : 0u; }
+	///	@brief	Gets the version, which is incremented whenever a snapshot is published.
+	///	@return		The version.
+	std::uint64_t version() const noexcept { return version_.load(); }
+
+	///	@brief	Constructor.
+	///	@param[in]	base	Base directory of the names.
+	///	@param[in]	budget	Memory budget in bytes. Templates beyond it are evicted. Shared nodes are not counted.
+	///	@param[in]	share	Whether identical subtrees of the templates are shared or not.
+	explicit registry_t(std::filesystem::path base, std::size_t budget = std::numeric_limits<std::size_t>::max(), bool share = false) :
+		base_{std::move(base)}, budget_{budget}, interner_{share ? std::make_shared<interner_t>() : nullptr}, mutex_{}, snapshot_{std::make_shared<impl::map_t const>()}, version_{}, size_{} {}
+	registry_t(registry_t const&)			 = delete;
+	registry_t& operator=(registry_t const&) = delete;
+
+private:
+	///	@brief	Resolves the @p name to the path of the pug file in the base directory.
+	///		It is checked lexically, so that symbolic links in the base directory are trusted.
+	///	@param[in]	name	Name of the template.
+	///	@return		Path of the pug file.
+	///	@throws		xxx::pug::ex::io_error		It throws the exception if the name is absolute or goes out of the base directory.
+	std::filesystem::path resolve(std::string_view name) const {
+		auto const relative = std::filesystem::path{name}.lexically_normal();
+		if (relative.empty() || relative.has_root_path() || *relative.begin() == "..") {
+			throw ex::io_error(std::filesystem::path{name}, std::make_error_code(std::errc::permission_denied));
+		}
+		return base_ / relative;
+	}
+	///	@brief	Compiles the template of the @p name and publishes it.
+	///	@param[in]	name	Name of the template.
+	///	@return		The compiled template.
+	std::shared_ptr<impl::entry_t const> load(std::string_view name) {
+		auto entry = std::make_shared<impl::entry_t const>(resolve(name), version_.load() + 1u, interner_);	  // It is compiled out of the lock.
+		std::lock_guard lock{mutex_};
+		auto			map = std::make_shared<impl::map_t>(*snapshot_.load());
+		if (auto const itr = map->find(name); itr != map->cend() && itr->second->time == entry->time) {
+			return itr->second;	   // Another thread has published it.
+		}
+		map->insert_or_assign(std::string{name}, entry);
+		publish(std::move(map), name);
+		return entry;
+	}
+	///	@brief	Evicts templates beyond the budget, and publishes the @p map as a new snapshot.
+	///		Templates used at older versions are evicted earlier.
+	///	@param[in]	map		Map to publish.
+	///	@param[in]	keep	Name of the template never evicted.
+	void publish(std::shared_ptr<impl::map_t> map, std::string_view keep) {
+		auto size = std::accumulate(map->cbegin(), map->cend(), std::size_t{}, [](auto n, auto const& a) { return n + a.second->size; });
+		if (budget_ < size) {
+			std::vector<impl::map_t::const_iterator> order;
+			for (auto itr = map->cbegin(); itr != map->cend(); ++itr) {
+				if (itr->first != keep) order.push_back(itr);
+			}
+			std::ranges::sort(order, std::less<>{}, [](auto const& a) { return a->second->used.load(std::memory_order_relaxed); });
+			for (auto itr = order.cbegin(); budget_ < size && itr != order.cend(); ++itr) {
+				size -= (*itr)->second->size;
+				map->erase(*itr);
+			}
+		}
+		size_.store(size);
+		snapshot_.store(std::move(map));
+		version_.fetch_add(1u, std::memory_order_release);	  // Readers take the new snapshot.
+		if (interner_) (void)interner_->prune();			  // Nodes of the snapshots released already.
+	}
+
+	std::filesystem::path							 base_;		   ///< @brief	Base directory of the names.
+	std::size_t										 budget_;	   ///< @brief	Memory budget in bytes.
+	std::shared_ptr<interner_t>						 interner_;	   ///< @brief	Interner of the shared nodes. It is null if they are not shared.
+	std::mutex										 mutex_;	   ///< @brief	Mutex of writers. Readers never lock it.
+	std::atomic<std::shared_ptr<impl::map_t const>> snapshot_;	   ///< @brief	The latest snapshot.
+	std::atomic<std::uint64_t>						 version_;	   ///< @brief	Version of the latest snapshot.
+	std::atomic<std::size_t>						 size_;		   ///< @brief	Resident bytes of the latest snapshot.
+};
+
+}	 // namespace xxx::pug::registry
+
+#endif	  // xxx_PUG_REGISTRY_HPP_
@@ -0,0 +1,337 @@
+﻿///	@file
+///	@brief		pug++  - Render daemon over a Unix domain socket
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///	@note		It depends on POSIX.
+///
+///	A request is the path of a pug file in the first line and a flat JSON object of variables following it.
+///	The client shuts down writing at the end of the request.
+///	A response is either 'OK' line followed by the HTML, or 'ERROR' line with its message.
+
+#ifndef xxx_PUG_SERVE_HPP_
+#define xxx_PUG_SERVE_HPP_
+
+#include "pug.hpp"
+#include "pug_json.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <stop_token>
+#include <unordered_map>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace xxx::pug::serve {
+namespace def {
+static std::string_view const	  ok_sv{"OK\n"};
+static std::string_view const	  error_sv{"ERROR "};
+static int const				  backlog{128};
+static std::size_t const		  buffer_size{64u * 1024u};
+static std::size_t const		  fragment_cache_size{64u * 1024u * 1024u};
+static std::size_t const		  max_iovecs{1024u};				///< @brief	Views sent at once, which is the minimum IOV_MAX on Linux.
+static std::size_t const		  max_request_size{1024u * 1024u};	///< @brief	Requests longer than it are dropped.
+static std::chrono::seconds const receive_timeout{10};				///< @brief	Time to read a whole request.
+}	 // namespace def
+
+namespace impl {
+
+///	@brief	Owner of a file descriptor.
+class fd_t {
+public:
+	///	@brief	Gets the file descriptor.
+	///	@return		The file descriptor.
+	int get() const noexcept { return fd_; }
+
+	///	@brief	Constructor.
+	///	@param[in]	fd	File descriptor to own.
+	explicit fd_t(int fd) noexcept :
+		fd_{fd} {}
+	///	@brief	Destructor.
+	~fd_t() {
+		if (0 <= fd_) ::close(fd_);
+	}
+	fd_t(fd_t&& that) noexcept :
+		fd_{std::exchange(that.fd_, -1)} {}
+	fd_t(fd_t const&)			 = delete;
+	fd_t& operator=(fd_t const&) = delete;
+
+private:
+	int fd_;	///< @brief	File descriptor.
+};
+
+///	@brief	Gets the error of the last system call.
+///	@param[in]	what	Name of the system call.
+///	@return		The exception.
+inline ex::io_error last_error(std::filesystem::path const& what) {
+	return ex::io_error{what, std::error_code{errno, std::generic_category()}};
+}
+
+///	@brief	Gets the address of the Unix domain socket.
+///	@param[in]	path	Path of the socket.
+///	@return		Address of the socket.
+inline sockaddr_un to_address(std::filesystem::path const& path) {
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	auto const s	= path.string();
+	if (sizeof(addr.sun_path) <= s.size()) throw ex::io_error{path, std::make_error_code(std::errc::filename_too_long)};
+	std::ranges::copy(s, addr.sun_path);
+	return addr;
+}
+
+///	@brief	Writes the whole @p data.
+///	@param[in]	fd		File descriptor to write.
+///	@param[in]	data	Data to write.
+inline void write_all(int fd, std::string_view data) {
+	while (! data.empty()) {
+		auto const n = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			throw last_error("send");
+		}
+		data = data.substr(static_cast<std::size_t>(n));
+	}
+}
+
+///	@brief	Writes the whole @p segments by gathering their views.
+///	@param[in]	fd			File descriptor to write.
+///	@param[in]	segments	Scatter-gather list to write.
+inline void write_all(int fd, segments_t const& segments) {
+	std::vector<iovec> iovecs;
+	iovecs.reserve(segments.views().size());
+	std::ranges::transform(segments.views(), std::back_inserter(iovecs), [](auto const& a) { return iovec{const_cast<char*>(a.data()), a.size()}; });
+	for (auto itr = iovecs.begin(); itr != iovecs.end();) {
+		msghdr message{};
+		message.msg_iov	   = &*itr;
+		message.msg_iovlen = std::min(static_cast<std::size_t>(iovecs.end() - itr), def::max_iovecs);
+		auto const n	   = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			throw last_error("sendmsg");
+		}
+		// Skips the sent views, and the rest of the partially sent view is sent again.
+		auto rest = static_cast<std::size_t>(n);
+		for (; itr != iovecs.end() && itr->iov_len <= rest; ++itr) {
+			rest -= itr->iov_len;
+		}
+		if (rest != 0u) {
+			itr->iov_base = static_cast<char*>(itr->iov_base) + rest;
+			itr->iov_len -= rest;
+		}
+	}
+}
+
+///	@brief	Sets the timeout of each receive from the socket.
+///	@param[in]	fd		File descriptor of the socket.
+///	@param[in]	timeout	Timeout. A receive waiting longer fails with EAGAIN.
+inline void set_receive_timeout(int fd, std::chrono::microseconds timeout) {
+	timeval const tv{static_cast<time_t>(timeout.count() / 1'000'000), static_cast<suseconds_t>(timeout.count() % 1'000'000)};
+	if (::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0) throw last_error("setsockopt");
+}
+
+///	@brief	Reads until the end of the stream.
+///	@param[in]	fd			File descriptor to read.
+///	@param[in]	max_size	Maximum size to read.
+///	@param[in]	deadline	Time by which the end of the stream is read.
+///	@return		Read data.
+///	@throws		xxx::pug::ex::io_error	It throws the exception if it failed to read, the stream is longer than the @p max_size, or the @p deadline has passed.
+inline std::string read_all(int fd, std::size_t max_size = std::numeric_limits<std::size_t>::max(), std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+	std::string out;
+	for (char buffer[def::buffer_size];;) {
+		auto const n = ::recv(fd, buffer, sizeof(buffer), 0);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			throw last_error("recv");
+		} else if (n == 0) {
+			return out;
+		} else if (max_size - out.size() < static_cast<std::size_t>(n)) {
+			throw ex::io_error{"recv", std::make_error_code(std::errc::message_size)};
+		} else if (deadline < std::chrono::steady_clock::now()) {
+			throw ex::io_error{"recv", std::make_error_code(std::errc::timed_out)};	   // A client sending slowly never occupies a worker.
+		}
+		out.append(buffer, static_cast<std::size_t>(n));
+	}
+}
+
+}	 // namespace impl
+
+///	@brief	Cache of compiled templates.
+///		A template is compiled again when its file is modified.
+class cache_t {
+public:
+	///	@brief	Gets the compiled template of the @p path.
+	///	@param[in]	path	Path of the pug file.
+	///	@return		Compiled template.
+	std::shared_ptr<template_t const> get(std::filesystem::path const& path) {
+		auto const time = std::filesystem::last_write_time(path);
+		auto const key	= path.string();
+		{
+			std::shared_lock lock{mutex_};
+			if (auto const itr = templates_.find(key); itr != templates_.cend() && itr->second.first == time) {
+				return itr->second.second;
+			}
+		}
+		auto const compiled = std::make_shared<template_t const>(compile_file(path));	 // It is compiled out of the lock.
+		std::unique_lock lock{mutex_};
+		templates_.insert_or_assign(key, std::make_pair(time, compiled));
+		return compiled;
+	}
+
+private:
+	using entry_t = std::pair<std::filesystem::file_time_type, std::shared_ptr<template_t const>>;
+	std::shared_mutex						 mutex_;		///< @brief	Mutex of the templates.
+	std::unordered_map<std::string, entry_t> templates_;	///< @brief	Compiled templates by path.
+};
+
+///	@brief	Handles a request and makes its response.
+///	@param[in]	cache		Cache of compiled templates.
+///	@param[in]	request		Request.
+///	@param[in]	options		Rendering options.
+///	@return		Response. Its HTML refers the source of the template without copying.
+inline segments_t respond(cache_t& cache, std::string_view request, options_t const& options) {
+	try {
+		auto const pos	= request.find('\n');
+		auto const path = request.substr(0, pos);
+		auto const doc	= json::parse_object(pos == std::string_view::npos ? std::string_view{} : request.substr(pos + 1));
+		segments_t response;
+		response.copy(def::ok_sv);
+		cache.get(path)->render_segments(response, doc.variables, options);
+		return response;
+	} catch (std::exception const& e) {
+		segments_t response;
+		response.copy(std::string{def::error_sv} + e.what() + '\n');
+		return response;
+	}
+}
+
+///	@brief	Render daemon over a Unix domain socket.
+///		Accepted clients are served by the pool of workers.
+///		Workers share a cache of fragments unless the options have their own.
+///		Fragments of modified templates are never hit again, so that they are evicted as the least recently used.
+///		Each request is rendered within the limits, and it is cancelled when the daemon stops,
+///		so that a bad template responds an error instead of occupying a worker.
+class server_t {
+public:
+	///	@brief	Serves clients until stop is requested.
+	void run() {
+		std::vector<std::jthread> workers;
+		workers.reserve(workers_);
+		std::generate_n(std::back_inserter(workers), workers_, [this] { return std::jthread{[this](std::stop_token token) { work(token); }}; });
+
+		while (! stopped_) {
+			int const fd = ::accept(listener_.get(), nullptr, nullptr);
+			if (fd < 0) {
+				if (errno == EINTR || errno == ECONNABORTED) continue;
+				if (stopped_) break;
+				throw impl::last_error("accept");
+			}
+			{
+				std::lock_guard lock{mutex_};
+				clients_.emplace_back(fd);
+			}
+			cv_.notify_one();
+		}
+	}	 // Workers are stopped and joined.
+	///	@brief	Requests to stop.
+	///		It only calls async-signal-safe functions, so that a signal handler can call it.
+	void stop() noexcept {
+		stopped_ = true;
+		::shutdown(listener_.get(), SHUT_RDWR);
+	}
+
+	///	@brief	Constructor.
+	///	@param[in]	path		Path of the socket.
+	///	@param[in]	workers		Count of the workers.
+	///	@param[in]	options		Rendering options.
+	///	@param[in]	limits		Resource limits of each request.
+	///	@throws		xxx::pug::ex::io_error		It throws the exception if the @p path is an existing file other than a socket.
+	server_t(std::filesystem::path const& path, std::size_t workers, options_t const& options, limits_t const& limits = limits_t{}) :
+		path_{path}, workers_{std::max<std::size_t>(1u, workers)}, options_{options}, limits_{limits}, listener_{::socket(AF_UNIX, SOCK_STREAM, 0)}, cache_{}, fragments_{def::fragment_cache_size}, mutex_{}, cv_{}, clients_{}, stopped_{} {
+		if (listener_.get() < 0) throw impl::last_error("socket");
+		if (! options_.cache) options_.cache = &fragments_;
+		auto const addr = impl::to_address(path);
+		if (auto const status = std::filesystem::symlink_status(path); std::filesystem::is_socket(status)) {
+			std::filesystem::remove(path);	  // The socket left by the previous server.
+		} else if (std::filesystem::exists(status)) {
+			throw ex::io_error{path, std::make_error_code(std::errc::file_exists)};
+		}
+		if (::bind(listener_.get(), reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0) throw impl::last_error(path);
+		if (::listen(listener_.get(), def::backlog) != 0) throw impl::last_error(path);
+	}
+	///	@brief	Destructor.
+	~server_t() {
+		std::error_code ec;
+		if (std::filesystem::is_socket(std::filesystem::symlink_status(path_, ec))) std::filesystem::remove(path_, ec);
+	}
+	server_t(server_t const&)			 = delete;
+	server_t& operator=(server_t const&) = delete;
+
+private:
+	///	@brief	Serves clients as a worker.
+	///	@param[in]	token	Token to stop.
+	void work(std::stop_token token) {
+		while (! token.stop_requested()) {
+			std::unique_lock lock{mutex_};
+			if (! cv_.wait(lock, token, [this] { return ! clients_.empty(); })) break;
+			auto const client = std::move(clients_.front());
+			clients_.pop_front();
+			lock.unlock();
+
+			try {
+				impl::set_receive_timeout(client.get(), def::receive_timeout);
+				auto const request = impl::read_all(client.get(), def::max_request_size, std::chrono::steady_clock::now() + def::receive_timeout);
+				governor_t governor{limits_, token};	// The deadline starts after the request is read.
+				auto	   options = options_;
+				options.governor   = &governor;
+				impl::write_all(client.get(), respond(cache_, request, options));
+			} catch (std::exception const&) {
+				// The client is just dropped because it has gone.
+			}
+		}
+	}
+
+	std::filesystem::path		path_;		   ///< @brief	Path of the socket.
+	std::size_t					workers_;	   ///< @brief	Count of the workers.
+	options_t					options_;	   ///< @brief	Rendering options.
+	limits_t					limits_;	   ///< @brief	Resource limits of each request.
+	impl::fd_t					listener_;	   ///< @brief	Listening socket.
+	cache_t						cache_;		   ///< @brief	Cache of compiled templates.
+	fragment_cache_t			fragments_;	   ///< @brief	Cache of rendered fragments.
+	std::mutex					mutex_;		   ///< @brief	Mutex of the clients.
+	std::condition_variable_any cv_;		   ///< @brief	Condition to notify accepted clients.
+	std::deque<impl::fd_t>		clients_;	   ///< @brief	Accepted clients to serve.
+	std::atomic<bool>			stopped_;	   ///< @brief	Whether stop is requested or not.
+};
+
+///	@brief	Requests the daemon to translate a pug file.
+///	@param[in]	socket		Path of the socket.
+///	@param[in]	path		Path of the pug file. It should be absolute because the daemon resolves it.
+///	@param[in]	json		Variables formatted as a flat JSON object.
+///	@return		String of generated HTML.
+///	@throws		xxx::pug::ex::syntax_error	It throws the exception if the daemon failed to translate.
+///	@throws		xxx::pug::ex::io_error		It throws the exception if an I/O error occurred.
+inline std::string request(std::filesystem::path const& socket, std::filesystem::path const& path, std::string_view json = std::string_view{}) {
+	impl::fd_t const fd{::socket(AF_UNIX, SOCK_STREAM, 0)};
+	if (fd.get() < 0) throw impl::last_error("socket");
+	auto const addr = impl::to_address(socket);
+	if (::connect(fd.get(), reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0) throw impl::last_error(socket);
+
+	impl::write_all(fd.get(), path.string() + '\n' + std::string{json});
+	::shutdown(fd.get(), SHUT_WR);
+	auto response = impl::read_all(fd.get());
+	if (! response.starts_with(def::ok_sv)) {
+		throw ex::syntax_error(response.starts_with(def::error_sv) ? response.substr(def::error_sv.size()) : response);
+	}
+	return response.erase(0, def::ok_sv.size());
+}
+
+}	 // namespace xxx::pug::serve
+
+#endif	  // xxx_PUG_SERVE_HPP_
@@ -0,0 +1,609 @@
+///	@file
+///	@brief		pug++  - Compile-time parsing of pug literals
+///	@author		Mura
+///	@copyright	(c) 2022-, Mura.
+///
+///	A pug literal is parsed into a static table of nodes while compiling,
+///	so that rendering only evaluates conditions and replaces variables.
+///	It supports a subset of pug:
+///		- doctype
+///		- elements with id, classes, attributes, and text (also '=' and '!=')
+///		- interpolation (#{xxx})
+///		- if, else if, and else
+///		- each over a literal list
+///	Any other syntax fails to compile as well as syntax errors.
+
+#ifndef xxx_PUG_STATIC_HPP_
+#define xxx_PUG_STATIC_HPP_
+
+#include "pug.hpp"
+#include <array>
+#include <span>
+
+namespace xxx::pug {
+namespace ct {
+
+///	@brief	String literal as a template argument.
+///	@tparam		N	Size of the string including the null character.
+template<std::size_t N>
+struct fixed_string_t {
+	char data[N]{};	   ///< @brief	Characters including the null character.
+
+	///	@brief	Gets the view of the string.
+	///	@return		View of the string without the null character.
+	constexpr std::string_view view() const noexcept { return {data, N - 1u}; }
+
+	///	@brief	Constructor.
+	///	@param[in]	s	String literal.
+	consteval fixed_string_t(char const (&s)[N]) { std::copy(s, s + N, data); }
+};
+
+///	@brief	Kind of node.
+enum class kind_t : unsigned char {
+	element,	///< @brief	Element with its text.
+	doctype,	///< @brief	Doctype.
+	if_,		///< @brief	If statement.
+	elif,		///< @brief	Else-if statement.
+	else_,		///< @brief	Else statement.
+	each,		///< @brief	Each statement.
+};
+
+///	@brief	Piece of string in the table.
+struct piece_t {
+	std::size_t offset{};	   ///< @brief	Offset of the characters.
+	std::size_t size{};		   ///< @brief	Size of the characters.
+	bool		variable{};	   ///< @brief	Whether it is the name of variable to replace or not.
+};
+
+///	@brief	Node in the table.
+///		Its children follow it, and its next sister is at the @p end.
+struct node_t {
+	kind_t		kind{};		///< @brief	Kind of node.
+	std::size_t nest{};		///< @brief	Nested level.
+	std::size_t end{};		///< @brief	Index after the last descendant.
+	std::size_t first{};	///< @brief	The first piece: the opening tag, operands, or items.
+	std::size_t last{};		///< @brief	Index after the last piece.
+	piece_t		name{};		///< @brief	Tag to close, operator, or variable of each.
+};
+
+///	@brief	Static table of nodes.
+///	@tparam		Nodes	Count of nodes.
+///	@tparam		Pieces	Count of pieces.
+///	@tparam		Chars	Count of characters.
+template<std::size_t Nodes, std::size_t Pieces, std::size_t Chars>
+struct table_t {
+	std::array<node_t, Nodes>	nodes{};	 ///< @brief	Nodes in pre-order.
+	std::array<piece_t, Pieces> pieces{};	 ///< @brief	Pieces of nodes.
+	std::array<char, Chars>		chars{};	 ///< @brief	Characters of pieces.
+
+	///	@brief	Gets the string of the @p piece.
+	///	@param[in]	piece	Piece.
+	///	@return		View of the string.
+	constexpr std::string_view str(piece_t const& piece) const noexcept { return {chars.data() + piece.offset, piece.size}; }
+};
+
+///	@brief	Reports a syntax error of the pug literal.
+///		It is not constexpr, so that calling it while compiling fails to compile.
+///	@param[in]	what	Reason of the error.
+///	@throws		xxx::pug::ex::syntax_error	It always throws the exception.
+[[noreturn]] inline void syntax_error(char const* what) {
+	throw ex::syntax_error(what);
+}
+
+///	@brief	Builder of the table.
+///		It only counts sizes of the table unless @p Fill.
+///	@tparam		Fill	Whether it fills the table or not.
+///	@tparam		Nodes	Count of nodes.
+///	@tparam		Pieces	Count of pieces.
+///	@tparam		Chars	Count of characters.
+template<bool Fill, std::size_t Nodes = 0u, std::size_t Pieces = 0u, std::size_t Chars = 0u>
+class builder_t {
+public:
+	///	@brief	Adds a node.
+	///	@param[in]	node	Node to add.
+	///	@return		Index of the node.
+	constexpr std::size_t add_node(node_t const& node) {
+		if constexpr (Fill) table_.nodes[nodes_] = node;
+		return nodes_++;
+	}
+	///	@brief	Closes the node after its descendants.
+	///	@param[in]	index	Index of the node.
+	constexpr void close_node(std::size_t index) {
+		if constexpr (Fill) table_.nodes[index].end = nodes_;
+	}
+	///	@brief	Adds a piece of string.
+	///	@param[in]	s			String.
+	///	@param[in]	variable	Whether it is the name of variable or not.
+	///	@return		The piece.
+	constexpr piece_t add_piece(std::string_view s, bool variable = false) {
+		piece_t const piece{chars_, s.size(), variable};
+		if constexpr (Fill) table_.pieces[pieces_] = piece;
+		++pieces_;
+		append_chars(s);
+		merging_ = ! variable;
+		return piece;
+	}
+	///	@brief	Appends string to the last piece if it is not a variable; otherwise, it adds a piece.
+	///	@param[in]	s	String.
+	constexpr void append(std::string_view s) {
+		if (s.empty()) return;
+		if (! merging_) {
+			(void)add_piece(s);
+			return;
+		}
+		if constexpr (Fill) table_.pieces[pieces_ - 1u].size += s.size();
+		append_chars(s);
+	}
+	///	@brief	Begins pieces of a node.
+	///	@return		Index of the first piece.
+	constexpr std::size_t begin_pieces() noexcept {
+		merging_ = false;
+		return pieces_;
+	}
+	///	@brief	Gets the current count of pieces.
+	///	@return		The count of pieces.
+	constexpr std::size_t pieces() const noexcept { return pieces_; }
+	///	@brief	Gets the current count of nodes.
+	///	@return		The count of nodes.
+	constexpr std::size_t nodes() const noexcept { return nodes_; }
+	///	@brief	Gets the current count of characters.
+	///	@return		The count of characters.
+	constexpr std::size_t chars() const noexcept { return chars_; }
+	///	@brief	Gets the table.
+	///	@return		The table.
+	constexpr auto const& table() const noexcept { return table_; }
+
+private:
+	///	@brief	Appends characters.
+	///	@param[in]	s	Characters.
+	constexpr void append_chars(std::string_view s) {
+		if constexpr (Fill) std::ranges::copy(s, table_.chars.begin() + chars_);
+		chars_ += s.size();
+	}
+
+	table_t<Nodes, Pieces, Chars> table_{};		 ///< @brief	Table to fill.
+	std::size_t					  nodes_{};		 ///< @brief	Count of nodes.
+	std::size_t					  pieces_{};	 ///< @brief	Count of pieces.
+	std::size_t					  chars_{};		 ///< @brief	Count of characters.
+	bool						  merging_{};	 ///< @brief	Whether the last piece can be extended or not.
+};
+
+///	@brief	Line of the pug literal.
+struct line_t {
+	std::size_t		 nest{};	///< @brief	Nested level.
+	std::string_view s{};		///< @brief	Line without indents.
+};
+
+///	@brief	Lines of the pug literal without empty lines and pug comments.
+class lines_t {
+public:
+	///	@brief	Gets whether no lines remain or not.
+	///	@return		It returns true if no lines remain; otherwise, it returns false.
+	constexpr bool empty() const noexcept { return ! current_; }
+	///	@brief	Gets the current line.
+	///	@return		The current line.
+	constexpr line_t const& front() const noexcept { return *current_; }
+	///	@brief	Goes to the next line.
+	constexpr void pop() {
+		for (current_.reset(); ! current_ && ! rest_.empty();) {
+			auto const pos = rest_.find('\n');
+			auto	   s   = rest_.substr(0, pos);
+			rest_		   = pos == std::string_view::npos ? std::string_view{} : rest_.substr(pos + 1u);
+			if (s.ends_with('\r')) s.remove_suffix(1u);
+
+			auto const nest = std::min(s.find_first_not_of('\t'), s.size());
+			s				= s.substr(nest);
+			if (s.find_first_not_of(" \t") == std::string_view::npos) continue;	 // Drops empty line.
+			if (s.starts_with("//") && ! s.starts_with("//-")) continue;			 // Drops pug comment.
+			current_ = line_t{nest, s};
+		}
+	}
+
+	///	@brief	Constructor.
+	///	@param[in]	pug		Pug literal.
+	constexpr explicit lines_t(std::string_view pug) :
+		rest_{pug}, current_{} {
+		pop();
+	}
+
+private:
+	std::string_view	  rest_;		///< @brief	Lines not read yet.
+	std::optional<line_t> current_;		///< @brief	The current line.
+};
+
+///	@brief	Gets whether the @p c can start an identifier or not.
+constexpr bool is_identifier_head(char c) noexcept {
+	return ('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z') || c == '_' || c == '-';
+}
+///	@brief	Gets whether the @p c can be in an identifier or not.
+constexpr bool is_identifier(char c) noexcept {
+	return is_identifier_head(c) || ('0' <= c && c <= '9');
+}
+///	@brief	Gets the length of the identifier at the head of the @p s.
+///	@return		Length of the identifier. Zero means it is not an identifier.
+constexpr std::size_t identifier_length(std::string_view s) noexcept {
+	if (s.empty() || ! is_identifier_head(s.front())) return 0u;
+	return std::min(s.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-"), s.size());
+}
+///	@brief	Skips spaces and tabs.
+constexpr std::string_view skip_blanks(std::string_view s) noexcept {
+	return s.substr(std::min(s.find_first_not_of(" \t"), s.size()));
+}
+///	@brief	Gets whether the @p s starts with the @p keyword followed by blanks or the end.
+constexpr bool starts_with_keyword(std::string_view s, std::string_view keyword) noexcept {
+	return s.starts_with(keyword) && (s.size() == keyword.size() || s[keyword.size()] == ' ' || s[keyword.size()] == '\t');
+}
+
+///	@brief	Appends the @p s replacing variables (#{xxx}) by pieces of variable.
+///	@tparam		B	Type of the builder.
+///	@param[in,out]	out		Builder.
+///	@param[in]		s		String.
+///	@param[in]		escape	Whether it escapes characters for HTML or not.
+template<typename B>
+constexpr void append_text(B& out, std::string_view s, bool escape = false) {
+	auto const append = [&out, escape](std::string_view text) {
+		if (! escape) {
+			out.append(text);
+			return;
+		}
+		for (auto const& c: text) {
+			switch (c) {
+			case '<': out.append("&lt;"); break;
+			case '>': out.append("&gt;"); break;
+			case '&': out.append("&amp;"); break;
+			case '"': out.append("&quot;"); break;
+			case '\'': out.append("&#39;"); break;
+			default: out.append(std::string_view{&c, 1u}); break;
+			}
+		}
+	};
+	for (;;) {
+		auto const pos = s.find(impl::def::var_sv);
+		auto const end = pos == std::string_view::npos ? pos : s.find('}', pos);
+		if (end == std::string_view::npos) {
+			append(s);
+			return;
+		}
+		append(s.substr(0u, pos));
+		(void)out.add_piece(s.substr(pos + impl::def::var_sv.size(), end - pos - impl::def::var_sv.size()), true);
+		s = s.substr(end + 1u);
+	}
+}
+
+///	@brief	Parses an element like the runtime parser.
+///	@tparam		B	Type of the builder.
+///	@param[in,out]	out		Builder.
+///	@param[in]		s		Line.
+///	@return		Tag name to close. It is empty for void elements.
+template<typename B>
+constexpr std::string_view parse_element(B& out, std::string_view s) {
+	auto tag = s.substr(0, (s.starts_with('#') || s.starts_with('.')) ? 0u : identifier_length(s));
+	if (tag.empty()) {
+		if (s.empty() || identifier_length(s.substr(1)) == 0u) syntax_error("invalid element");
+		tag = "div";	// The 'div' tag can be omitted.
+	} else {
+		s = s.substr(tag.size());
+	}
+	auto const void_tag = std::ranges::find(impl::def::void_tag_names, tag) != impl::def::void_tag_names.cend();
+	out.append("<");
+	out.append(tag);
+
+	bool escape = false;
+	if (s.starts_with(": ")) {
+		syntax_error("nested elements are unsupported");
+	} else if (s.starts_with("!=")) {
+		s = s.substr(2u);
+	} else if (s.starts_with('=')) {
+		escape = true;
+		s	   = s.substr(1u);
+	}
+	// ID
+	if (s.starts_with('#')) {
+		if (auto const n = identifier_length(s.substr(1u)); n != 0u) {
+			out.append(R"( id=")");
+			out.append(s.substr(1u, n));
+			out.append(R"(")");
+			s = s.substr(1u + n);
+		}
+	}
+	// Class
+	if (s.starts_with('.')) {
+		out.append(R"( class=")");
+		for (bool first = true; s.starts_with('.') && identifier_length(s.substr(1u)) != 0u; first = false) {
+			auto const n = identifier_length(s.substr(1u));
+			if (! first) out.append(" ");
+			out.append(s.substr(1u, n));
+			s = s.substr(1u + n);
+		}
+		out.append(R"(")");
+	}
+	// Attributes
+	if (s.starts_with('(')) {
+		s = s.substr(1u);
+		for (auto n = identifier_length(s); n != 0u; n = identifier_length(s)) {
+			out.append(" ");
+			out.append(s.substr(0u, n));
+			s = s.substr(n);
+			if (s.starts_with("='") || s.starts_with(R"(=")")) {
+				auto const end = s.find_first_of(R"('")", 2u);
+				if (end == std::string_view::npos) syntax_error("unterminated attribute");
+				if (s[1u] != s[end]) syntax_error("mismatched quotes of attribute");
+				out.append(R"(=")");
+				append_text(out, s.substr(2u, end - 2u));
+				out.append(R"(")");
+				s = s.substr(end + 1u);
+			}
+			s = s.substr(std::min(s.find_first_not_of(" ,"), s.size()));
+		}
+		if (! s.starts_with(')')) syntax_error("unterminated attributes");
+		out.append(" ");
+		s = s.substr(1u);
+	}
+	out.append(void_tag ? " />" : ">");
+
+	if (s.starts_with(": ")) syntax_error("nested elements are unsupported");
+	append_text(out, s.starts_with(' ') ? s.substr(1u) : s, escape);
+	return void_tag ? std::string_view{} : tag;
+}
+
+///	@brief	Parses a line.
+///	@tparam		B	Type of the builder.
+///	@param[in,out]	out			Builder.
+///	@param[in]		line		Line.
+///	@param[in]		previous	Kind of the previous sister. Null means there is no previous sister.
+///	@return		It returns the followings:
+///		-#	Index of the node.
+///		-#	Kind of the node.
+template<typename B>
+constexpr std::pair<std::size_t, kind_t> parse_line(B& out, line_t const& line, std::optional<kind_t> previous) {
+	using namespace std::string_view_literals;
+	auto s = line.s;
+	if (s.starts_with("//-")) syntax_error("unsupported syntax");
+	for (auto const keyword: {"include"sv, "extends"sv, "block"sv, "case"sv, "when"sv, "default"sv, "mixin"sv, "-"sv, "|"sv, "."sv}) {
+		if (starts_with_keyword(s, keyword)) syntax_error("unsupported syntax");
+	}
+
+	node_t node{kind_t::element, line.nest};
+	node.first = out.begin_pieces();
+	if (8u < s.size() && std::ranges::equal(s.substr(0u, 8u), "doctype "sv, [](char a, char b) { return (a | 0x20) == b; })) {
+		node.kind		= kind_t::doctype;
+		auto const type = s.substr(8u);
+		if (std::ranges::any_of(type, [](char c) { return c == '-' || ! is_identifier(c); })) syntax_error("invalid doctype");
+		out.append("<!DOCTYPE ");
+		out.append(type);
+		out.append(">");
+	} else if (starts_with_keyword(s, "if") || (starts_with_keyword(s, "else") && starts_with_keyword(skip_blanks(s.substr(4u)), "if"))) {
+		// Pieces are the left-hand-side operand, the operator, and the right-hand-side operand.
+		node.kind = starts_with_keyword(s, "if") ? kind_t::if_ : kind_t::elif;
+		if (node.kind == kind_t::elif && previous != kind_t::if_ && previous != kind_t::elif) syntax_error("'else if' without 'if'");
+		for (auto condition = skip_blanks(node.kind == kind_t::if_ ? s.substr(2u) : skip_blanks(s.substr(4u)).substr(2u)); ! condition.empty(); condition = skip_blanks(condition)) {
+			auto const n	 = std::min(condition.find_first_of(" \t"), condition.size());
+			auto const token = condition.substr(0u, n);
+			if (out.pieces() - node.first == 1u && std::ranges::find(impl::def::compare_op_names, token) == impl::def::compare_op_names.cend()) {
+				syntax_error("unsupported operator");
+			}
+			(void)out.add_piece(token);
+			condition = condition.substr(n);
+		}
+		if (out.pieces() - node.first != 3u) syntax_error("condition must be a binary comparison");
+	} else if (starts_with_keyword(s, "else")) {
+		node.kind = kind_t::else_;
+		if (! skip_blanks(s.substr(4u)).empty()) syntax_error("invalid else");
+		if (previous != kind_t::if_ && previous != kind_t::elif) syntax_error("'else' without 'if'");
+	} else if (starts_with_keyword(s, "each")) {
+		// Pieces are the items, and the name is the variable.
+		node.kind	 = kind_t::each;
+		s			 = skip_blanks(s.substr(4u));
+		auto const n = identifier_length(s);
+		if (n == 0u) syntax_error("invalid variable of each");
+		node.name = out.add_piece(s.substr(0u, n));
+		s		  = skip_blanks(s.substr(n));
+		if (! s.starts_with("in")) syntax_error("each without in");
+		s = skip_blanks(s.substr(2u));
+		if (! s.starts_with('[') || ! s.ends_with(']')) syntax_error("each needs a literal list");
+		node.first = out.begin_pieces();
+		for (auto items = s.substr(1u, s.size() - 2u); ! items.empty();) {
+			auto const pos	= items.find(',');
+			auto	   item = skip_blanks(items.substr(0u, pos));
+			items			= pos == std::string_view::npos ? std::string_view{} : items.substr(pos + 1u);
+			if (item.empty()) syntax_error("empty item of each");
+			item = item.substr(0u, item.find_last_not_of(" \t") + 1u);
+			if (item.starts_with('"') || item.starts_with('\'')) {
+				if (item.size() < 2u || item.front() != item.back()) syntax_error("unterminated item of each");
+				item = item.substr(1u, item.size() - 2u);
+			}
+			(void)out.add_piece(item);
+		}
+	} else {
+		// Pieces are the opening tag with its text, and the name is the tag to close.
+		auto const tag = parse_element(out, s);
+		node.last	   = out.pieces();
+		if (! tag.empty()) node.name = out.add_piece(tag);
+		return {out.add_node(node), node.kind};
+	}
+	node.last = out.pieces();
+	return {out.add_node(node), node.kind};
+}
+
+///	@brief	Parses lines of the same nested level and their descendants.
+///	@tparam		B	Type of the builder.
+///	@param[in,out]	out		Builder.
+///	@param[in,out]	lines	Lines.
+///	@param[in]		nest	Nested level.
+template<typename B>
+constexpr void parse_lines(B& out, lines_t& lines, std::size_t nest) {
+	std::optional<kind_t> previous;
+	while (! lines.empty() && lines.front().nest == nest) {
+		auto const [index, kind] = parse_line(out, lines.front(), previous);
+		previous				 = kind;
+		lines.pop();
+		if (! lines.empty() && nest < lines.front().nest) {
+			if (lines.front().nest != nest + 1u) syntax_error("unexpected indent");
+			parse_lines(out, lines, nest + 1u);
+		}
+		out.close_node(index);
+	}
+}
+
+///	@brief	Parses the pug literal.
+///	@tparam		B	Type of the builder.
+///	@param[in]	pug		Pug literal.
+///	@return		The builder.
+template<typename B>
+constexpr B parse(std::string_view pug) {
+	B		out;
+	lines_t lines{pug};
+	parse_lines(out, lines, 0u);
+	if (! lines.empty()) syntax_error("unexpected indent");
+	return out;
+}
+
+///	@brief	Parses the pug literal into the static table.
+///	@tparam		Pug		Pug literal.
+///	@return		The table.
+template<fixed_string_t Pug>
+consteval auto compile() {
+	constexpr auto sizes = parse<builder_t<false>>(Pug.view());
+	return parse<builder_t<true, sizes.nodes(), sizes.pieces(), sizes.chars()>>(Pug.view()).table();
+}
+
+///	@brief	Scope of variables while rendering.
+///		Variables of each are bound over the given variables.
+class scope_t {
+public:
+	///	@brief	Finds the value of the variable.
+	///	@param[in]	name	Name of the variable.
+	///	@return		The value. It returns null if the variable is not defined.
+	std::optional<std::string_view> find(std::string_view name) const {
+		if (auto const itr = std::ranges::find(bindings_.crbegin(), bindings_.crend(), name, &binding_t::first); itr != bindings_.crend()) return itr->second;
+		if (auto const itr = variables_.find(name); itr != variables_.cend()) return itr->second;
+		return std::nullopt;
+	}
+	///	@brief	Gets the count of bindings.
+	///	@return		The count of bindings.
+	std::size_t size() const noexcept { return bindings_.size(); }
+	///	@brief	Binds the variable after dropping bindings over the @p size.
+	///	@param[in]	size	Count of bindings to keep.
+	///	@param[in]	name	Name of the variable.
+	///	@param[in]	value	Value of the variable.
+	void bind(std::size_t size, std::string_view name, std::string_view value) {
+		bindings_.resize(size);
+		bindings_.emplace_back(name, value);
+	}
+
+	///	@brief	Constructor.
+	///	@param[in]	variables	Variables.
+	explicit scope_t(variables_t const& variables) :
+		variables_{variables}, bindings_{} {}
+
+private:
+	using binding_t = std::pair<std::string_view, std::string_view>;
+
+	variables_t const&	   variables_;	  ///< @brief	Given variables.
+	std::vector<binding_t> bindings_;	  ///< @brief	Bound variables.
+};
+
+///	@brief	Renders nodes of the table.
+///	@tparam		Table	Type of the table.
+///	@param[in]		table	Table.
+///	@param[in]		first	Index of the first node.
+///	@param[in]		last	Index after the last node.
+///	@param[in,out]	scope	Scope of variables.
+///	@param[in]		options	Rendering options.
+///	@param[in,out]	out		Generated HTML.
+template<typename Table>
+void render(Table const& table, std::size_t first, std::size_t last, scope_t& scope, options_t const& options, std::string& out) {
+	auto const pieces = [&table](node_t const& node) { return std::span{table.pieces.data() + node.first, node.last - node.first}; };
+	auto const append = [&table, &scope, &out](piece_t const& piece) {
+		auto const s = table.str(piece);
+		if (! piece.variable) {
+			out += s;
+		} else if (auto const value = scope.find(s); value) {
+			out += *value;
+		} else {
+			((out += impl::def::var_sv) += s) += '}';	 // Undefined variable is kept as it is.
+		}
+	};
+	auto const evaluate = [&table, &scope](node_t const& node) {
+		auto const operand = [&table, &scope](piece_t const& piece) { return impl::eval::to_operand(table.str(piece), scope.find(table.str(piece))); };
+		auto const rhs	   = operand(table.pieces[node.first + 2u]);
+		return impl::eval::compare(operand(table.pieces[node.first]), table.str(table.pieces[node.first + 1u]), rhs);
+	};
+
+	for (auto i = first; i < last; i = table.nodes[i].end) {
+		auto const& node = table.nodes[i];
+		switch (node.kind) {
+		case kind_t::element:
+		case kind_t::doctype:
+			if (! options.compact && node.kind == kind_t::element) out.append(node.nest, '\t');
+			std::ranges::for_each(pieces(node), append);
+			if (! options.compact) out += '\n';
+			render(table, i + 1u, node.end, scope, options, out);
+			if (node.name.size != 0u) {
+				if (! options.compact) out.append(node.nest, '\t');
+				((out += "</") += table.str(node.name)) += '>';
+				if (! options.compact) out += '\n';
+			}
+			break;
+		case kind_t::if_:
+			// Renders the first satisfied one of the sequence of if, else-ifs, and else.
+			for (auto j = i;; j = table.nodes[j].end) {
+				if (table.nodes[j].kind == kind_t::else_ || evaluate(table.nodes[j])) {
+					render(table, j + 1u, table.nodes[j].end, scope, options, out);
+					break;
+				}
+				if (auto const next = table.nodes[j].end; last <= next || (table.nodes[next].kind != kind_t::elif && table.nodes[next].kind != kind_t::else_)) break;
+			}
+			break;
+		case kind_t::elif:
+		case kind_t::else_:
+			break;	  // There is nothing to do because it is handled at if statement.
+		case kind_t::each:
+			// Every iteration starts from the same scope, and the last one remains for the following lines.
+			for (auto const size = scope.size(); auto const& item: pieces(node)) {
+				scope.bind(size, table.str(node.name), table.str(item));
+				render(table, i + 1u, node.end, scope, options, out);
+			}
+			break;
+		}
+	}
+}
+
+}	 // namespace ct
+
+///	@brief	Template parsed while compiling.
+///		Its pug literal is parsed into a static table of nodes, and syntax errors fail to compile.
+///	@tparam		Pug		Pug literal.
+template<ct::fixed_string_t Pug>
+class static_template_t {
+public:
+	///	@brief	Translates the template to HTML string.
+	///	@param[in]	variables	Variables.
+	///	@param[in]	options		Rendering options.
+	///	@return		String of generated HTML.
+	std::string render(variables_t const& variables = variables_t{}, options_t const& options = options_t{}) const {
+		std::string	  out;
+		ct::scope_t scope{variables};
+		ct::render(table_, 0u, table_.nodes.size(), scope, options, out);
+		return out;
+	}
+
+private:
+	static constexpr auto table_ = ct::compile<Pug>();	  ///< @brief	Static table of nodes.
+};
+
+namespace literals {
+
+///	@brief	Makes a template parsed while compiling from the pug literal.
+///		e.g., "p Hello, #{name}"_pug.render(variables)
+///	@tparam		Pug		Pug literal.
+///	@return		The template.
+template<ct::fixed_string_t Pug>
+consteval static_template_t<Pug> operator""_pug() {
+	return {};
+}
+
+}	 // namespace literals
+}	 // namespace xxx::pug
+
+#endif	  // xxx_PUG_STATIC_HPP_
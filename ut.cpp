@@ -5,7 +5,16 @@
 
 #include <system_error>
 #include "pug.hpp"
+#include "pug_cache.hpp"
+#include "pug_json.hpp"
+#include "pug_registry.hpp"
+#include "pug_static.hpp"
+#if __has_include(<sys/un.h>)
+#include "pug_serve.hpp"
+#endif
+#include "libpug.h"
 #include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <string>
 
@@ -1157,3 +1166,687 @@ TEST(def_else_re, Regex) {
 #endif
 
 ///	@}
+
+///	@name	Rendering
+///	@{
+
+TEST(render_each, Parallel) {
+	std::string pug{"each i in ["};
+	std::string expected;
+	for (int i = 0; i < 1000; ++i) {
+		pug += (i == 0 ? "" : ", ") + std::to_string(i);
+		expected += "\t<li>" + std::to_string(i) + "\n\t</li>\n";
+	}
+	pug += "]\n\tli #{i}\n";
+	EXPECT_EQ(expected, xxx::pug::pug_string(pug));
+}
+TEST(render_for, Parallel) {
+	// Values are taken in several batches.
+	std::string const pug{"- for (var i = 0; i < 10000; i += 1)\n\tli #{i}\n"};
+	std::string		  expected;
+	for (int i = 0; i < 10000; ++i) {
+		expected += "\t<li>" + std::to_string(i) + "\n\t</li>\n";
+	}
+	EXPECT_EQ(expected, xxx::pug::pug_string(pug));
+	EXPECT_TRUE(xxx::pug::impl::parse_file(pug)->children()[0]->independent());
+}
+TEST(render_for, Dependent) {
+	// The body modifies the variable for the following iterations.
+	std::string const pug{"- var n = a\n- for (var i = 0; i < 100; i += 1)\n\tli #{n}\n\t- var n = b\n"};
+	std::string		  expected;
+	for (int i = 0; i < 100; ++i) {
+		expected += "\t<li>"s + (i == 0 ? "a" : "b") + "\n\t</li>\n";
+	}
+	EXPECT_EQ(expected, xxx::pug::pug_string(pug));
+	EXPECT_FALSE(xxx::pug::impl::parse_file(pug)->children()[1]->independent());
+}
+TEST(render_for, Raw) {
+	// Lines in the raw block are parsed, and they modify the variable as well.
+	std::string const pug{"- var n = a\n- for (var i = 0; i < 100; i += 1)\n\tp #{n}\n\t.\n\t\t- var n = b\n"};
+	std::string		  expected;
+	for (int i = 0; i < 100; ++i) {
+		expected += "\t<p>"s + (i == 0 ? "a" : "b") + "\n\t</p>\n\t\t- var n = b\n";
+	}
+	EXPECT_EQ(expected, xxx::pug::pug_string(pug));
+	EXPECT_FALSE(xxx::pug::impl::parse_file(pug)->children()[1]->independent());
+}
+TEST(render_for, Workers) {
+	xxx::pug::impl::workers_t workers{3u};
+	std::atomic<int>		  count{};
+	for (int i = 0; i < 100; ++i) workers.run([&count] { ++count; }, workers.size());
+	EXPECT_EQ(400, count);
+}
+TEST(render_for, Error) {
+	std::string const pug{"- for (var i = 0; i < 1000; i += 1)\n\tif i == x\n\t\tli\n"};
+	EXPECT_THROW(xxx::pug::pug_string(pug), xxx::pug::ex::syntax_error);
+}
+
+TEST(render_compact, Element) {
+	xxx::pug::options_t options;
+	options.compact = true;
+	EXPECT_EQ("<!DOCTYPE html><html><body><p id=\"a\">Abc</p><br /></body></html>"s, xxx::pug::pug_string("doctype html\nhtml\n\tbody\n\t\tp#a Abc\n\t\tbr\n", "./", options));
+	EXPECT_EQ("<ul><li>1</li><li>2</li></ul>"s, xxx::pug::pug_string("ul\n\teach i in [1, 2]\n\t\tli #{i}\n", "./", options));
+}
+TEST(render_compact, Folding) {
+	xxx::pug::options_t options;
+	options.compact = true;
+	EXPECT_EQ("<p>Abc def</p>"s, xxx::pug::pug_string("p\n\t| Abc \n\t| def\n", "./", options));
+}
+
+TEST(render_template, Repeat) {
+	xxx::pug::template_t const t{"p #{a}\n"};
+	EXPECT_EQ("<p>1\n</p>\n"s, t.render({{"a", "1"}}));
+	EXPECT_EQ("<p>2\n</p>\n"s, t.render({{"a", "2"}}));
+}
+TEST(render_template, Slots) {
+	xxx::pug::options_t options;
+	options.compact = true;
+	xxx::pug::template_t const t{"- var n = #{a}\n- for (var i = 0; i < 2; i += 1)\n\tp #{n} #{i} #{c}\n"};
+	// Variables the template never refers are looked up if values refer them, and recursion stops.
+	EXPECT_EQ("<p>1 0 #{c}</p><p>1 1 #{c}</p>"s, t.render({{"a", "#{b}"}, {"b", "1"}, {"c", "#{c}"}}, options));
+	std::vector<std::string> names;
+	for (int i = 0; i < 1000; ++i) names.push_back("v" + std::to_string(i));
+	xxx::pug::variables_t variables{{"a", "2"}};
+	std::ranges::for_each(names, [&variables](auto const& a) { variables.emplace(a, "x"); });
+	EXPECT_EQ("<p>2 0 #{c}</p><p>2 1 #{c}</p>"s, t.render(variables, options));
+}
+
+TEST(render_fragment, Cache) {
+	xxx::pug::template_t const t{"div\n\tp #{a}\n\t- var b = x\nul\n\teach i in [1, 2]\n\t\tli #{i} #{b}\n"};
+	xxx::pug::fragment_cache_t cache{1024u};
+	xxx::pug::options_t const  options{.cache = &cache};
+	for (auto const* a: {"1", "2", "1"}) {
+		xxx::pug::variables_t const variables{{"a", a}};
+		EXPECT_EQ(t.render(variables), t.render(variables, options));
+	}
+	EXPECT_EQ(3u, cache.hits());	// The 'ul' except the first, and the 'div' of the last.
+	EXPECT_EQ(3u, cache.misses());
+	cache.clear();
+	EXPECT_EQ(0u, cache.size());
+}
+TEST(render_fragment, Raw) {
+	// Lines in the raw block are parsed, so that the fragment writes the variable.
+	xxx::pug::template_t const	t{"div\n\t.\n\t\t- var n = b\np #{n}\n"};
+	xxx::pug::fragment_cache_t	cache{1024u};
+	xxx::pug::options_t const	options{.cache = &cache};
+	xxx::pug::variables_t const variables{{"n", "a"}};
+	for (int i = 0; i < 2; ++i) {
+		EXPECT_EQ(t.render(variables), t.render(variables, options));
+	}
+}
+TEST(render_fragment, Evicted) {
+	xxx::pug::template_t const t{"p #{a}\n"};
+	xxx::pug::fragment_cache_t cache{16u};
+	xxx::pug::options_t const  options{.cache = &cache};
+	for (auto const* a: {"1", "2", "1"}) {
+		EXPECT_EQ("<p>"s + a + "\n</p>\n", t.render({{"a", a}}, options));
+	}
+	EXPECT_EQ(0u, cache.hits());
+	EXPECT_LE(cache.size(), cache.capacity());
+}
+
+TEST(render_static, Equivalent) {
+	using namespace xxx::pug::literals;
+	auto const					t = "doctype html\nhtml\n\tbody#main.a.b(data-v='#{v}', hidden)\n\t\tp= <#{v}>\n\t\tif v == 1\n\t\t\tp one\n\t\telse if v == 2\n\t\t\tp two\n\t\telse\n\t\t\tp #{u}\n\t\teach i in [1, 'x']\n\t\t\tli #{i}\n\t\tbr\n\t\tp #{i}\n"_pug;
+	std::string_view const		pug{"doctype html\nhtml\n\tbody#main.a.b(data-v='#{v}', hidden)\n\t\tp= <#{v}>\n\t\tif v == 1\n\t\t\tp one\n\t\telse if v == 2\n\t\t\tp two\n\t\telse\n\t\t\tp #{u}\n\t\teach i in [1, 'x']\n\t\t\tli #{i}\n\t\tbr\n\t\tp #{i}\n"};
+	xxx::pug::options_t const	compact{.compact = true};
+	for (auto const* v: {"1", "2", "3"}) {
+		xxx::pug::variables_t const variables{{"v", v}};
+		EXPECT_EQ(xxx::pug::pug_string_with_variables(variables, pug), t.render(variables));
+		EXPECT_EQ(xxx::pug::pug_string_with_variables(variables, pug, "./", compact), t.render(variables, compact));
+	}
+}
+TEST(render_static, Error) {
+	using namespace xxx::pug::literals;
+	EXPECT_THROW((void)"if a == 1\n\tp\n"_pug.render(), xxx::pug::ex::syntax_error);	   // Undefined operand is an error while rendering as well.
+}
+
+TEST(render_dependencies, Include) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-dependencies";
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "layout.pug"} << "html\n\tblock body\n\tinclude footer.pug\n";
+	std::ofstream{dir / "footer.pug"} << "p Footer\n";
+	std::ofstream{dir / "page.pug"} << "block body\n\tp Body\nextends layout.pug\n";
+
+	std::vector<std::filesystem::path> dependencies;
+	xxx::pug::options_t const		   options{.dependencies = &dependencies};
+	auto const						   compiled = xxx::pug::compile_file(dir / "page.pug");
+	EXPECT_EQ("<html>\n\t<p>Body\n\t</p>\n\t<p>Footer\n\t</p>\n</html>\n"s, compiled.render({}, options));
+	for (auto&& chunk: xxx::pug::render_chunks(compiled, {}, options)) {
+		EXPECT_FALSE(chunk.empty());
+	}
+	EXPECT_EQ((std::vector<std::filesystem::path>{dir / "layout.pug", dir / "footer.pug", dir / "layout.pug", dir / "footer.pug"}), dependencies);
+	std::filesystem::remove_all(dir);
+}
+TEST(render_dependencies, Defines) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-dependencies-defines";
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "defines.pug"} << "- var name = Included\nblock body\n\tp Body\n";
+
+	// Names defined by the included file are used after its nodes are released.
+	xxx::pug::template_t const compiled{"include defines.pug\np #{name}\nblock body\n", dir / "page.pug"};
+	std::string const		   expected{"<p>Included\n</p>\n\t<p>Body\n\t</p>\n"};
+	EXPECT_EQ(expected, compiled.render());
+	EXPECT_EQ(expected, compiled.render_segments().str());
+	std::string chunks;
+	for (auto&& chunk: xxx::pug::render_chunks(compiled, {}, {}, 1u)) chunks += chunk;
+	EXPECT_EQ(expected, chunks);
+	std::filesystem::remove_all(dir);
+}
+TEST(render_dependencies, Each) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-dependencies-each";
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "item.pug"} << "li Item\n";
+	std::string pug{"each i in [0"};
+	for (int i = 1; i < 100; ++i) pug += ", " + std::to_string(i);
+	pug += "]\n\tinclude item.pug\n";
+
+	// Iterations loading other files are rendered serially, so that the dependencies are collected in order.
+	std::vector<std::filesystem::path> dependencies;
+	xxx::pug::options_t const		   options{.dependencies = &dependencies};
+	(void)xxx::pug::template_t{pug, dir / "page.pug"}.render({}, options);
+	EXPECT_EQ(std::vector<std::filesystem::path>(100u, dir / "item.pug"), dependencies);
+	std::filesystem::remove_all(dir);
+}
+
+TEST(render_governor, Limits) {
+	auto const kind = [](std::string const& pug, xxx::pug::limits_t const& limits, std::stop_token token = {}) {
+		xxx::pug::governor_t governor{limits, token};
+		try {
+			(void)xxx::pug::template_t{pug}.render({}, xxx::pug::options_t{.governor = &governor});
+		} catch (xxx::pug::ex::limit_error const& e) {
+			return std::optional{e.kind()};
+		}
+		return std::optional<xxx::pug::ex::limit_error::kind_t>{};
+	};
+	using kind_t = xxx::pug::ex::limit_error::kind_t;
+	std::string const endless{"- for (var i = 0; i < 3; i += 0)\n\tp #{i}\n"};
+	EXPECT_EQ(kind_t::iterations, kind(endless, {.iterations = 1000u}));
+	EXPECT_EQ(kind_t::deadline, kind(endless, {.timeout = std::chrono::milliseconds{10}}));
+	EXPECT_EQ(kind_t::output_size, kind("- for (var i = 0; i < 10000; i += 1)\n\tp #{i}\n", {.output_size = 1000u}));
+	EXPECT_EQ(kind_t::memory, kind(endless, {.memory = 1000u}));
+	std::stop_source stop;
+	stop.request_stop();
+	EXPECT_EQ(kind_t::stopped, kind("p Abc\n", {}, stop.get_token()));
+	EXPECT_EQ(std::nullopt, kind("each i in [1, 2]\n\tp #{i}\n", {.iterations = 2u, .output_size = 24u}));
+	EXPECT_EQ(kind_t::iterations, kind("each i in [1, 2]\n\tp #{i}\n", {.iterations = 1u}));
+}
+TEST(render_governor, IncludeDepth) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-governor";
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "self.pug"} << "p Self\ninclude self.pug\n";
+	std::ofstream{dir / "page.pug"} << "include footer.pug\ninclude footer.pug\n";
+	std::ofstream{dir / "footer.pug"} << "p Footer\n";
+
+	for (auto const& [name, depth, limited]: {std::tuple{"self.pug", 8u, true}, std::tuple{"page.pug", 1u, false}}) {
+		auto const			 compiled = xxx::pug::compile_file(dir / name);
+		xxx::pug::governor_t governor{{.include_depth = depth}};
+		xxx::pug::options_t const options{.governor = &governor};
+		if (limited) {
+			EXPECT_THROW(compiled.render({}, options), xxx::pug::ex::limit_error);
+			EXPECT_THROW(for (auto&& chunk: xxx::pug::render_chunks(compiled, {}, options)) (void)chunk, xxx::pug::ex::limit_error);
+		} else {
+			EXPECT_NO_THROW(compiled.render({}, options));
+			EXPECT_NO_THROW(compiled.render_segments({}, options));
+		}
+	}
+	std::filesystem::remove_all(dir);
+}
+
+TEST(check, Errors) {
+	EXPECT_TRUE(xxx::pug::check_string("doctype html\nhtml\n\tbody\n\t\tif a == 1\n\t\t\tp #{a}\n\t\telse\n\t\t\tp(class='b')\n").empty());
+	auto const errors = xxx::pug::check_string("p a\nif a = 1\n\tp\nelse\nelse\neach i in [1, \"x]\np #{a\ndiv(a='b\")\n");
+	std::vector<std::size_t> lines;
+	std::ranges::transform(errors, std::back_inserter(lines), &xxx::pug::diagnostic_t::line);
+	EXPECT_EQ((std::vector<std::size_t>{2u, 5u, 6u, 7u, 8u}), lines);
+	EXPECT_EQ(1u, xxx::pug::check_string("| a\n").size());
+}
+TEST(check, Include) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-check";
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "page.pug"} << "include part.pug\ninclude self.pug\ninclude missing.pug\n";
+	std::ofstream{dir / "part.pug"} << "p\n\tif a\n";
+	std::ofstream{dir / "self.pug"} << "p\ninclude self.pug\n";
+
+	auto const errors = xxx::pug::check_file(dir / "page.pug");
+	ASSERT_EQ(3u, errors.size());
+	EXPECT_EQ((xxx::pug::diagnostic_t{dir / "part.pug", 2u, "unsupported expression 'a'"}), errors[0]);
+	EXPECT_EQ((xxx::pug::diagnostic_t{dir / "self.pug", 2u, "recursive include 'self.pug'"}), errors[1]);
+	EXPECT_EQ((xxx::pug::diagnostic_t{dir / "page.pug", 3u, "missing file 'missing.pug'"}), errors[2]);
+	std::filesystem::remove_all(dir);
+}
+
+TEST(disk_cache, Sha256) {
+	using namespace xxx::pug::cache::impl;
+	EXPECT_EQ("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"s, to_hex(sha256_t{}.finish()));
+	EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"s, to_hex(sha256_t{}.update("abc").finish()));
+	EXPECT_EQ("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"s, to_hex(sha256_t{}.update("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").finish()));
+}
+TEST(disk_cache, Modified) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-disk-cache";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "footer.pug"} << "p Footer\n";
+	std::ofstream{dir / "page.html"} << "<p>Footer\n</p>\n";
+
+	xxx::pug::cache::disk_cache_t cache{dir / "cache"};
+	auto const					  key = xxx::pug::cache::disk_cache_t::key(dir / "page.pug", "include footer.pug\n", {{"a", "1"}}, "");
+	EXPECT_NE(key, xxx::pug::cache::disk_cache_t::key(dir / "page.pug", "include footer.pug\n", {{"a", "2"}}, ""));
+	EXPECT_NE(key, xxx::pug::cache::disk_cache_t::key(dir / "sub" / "page.pug", "include footer.pug\n", {{"a", "1"}}, ""));	  // It includes another footer.
+	EXPECT_EQ(key, xxx::pug::cache::disk_cache_t::key(dir / "sub" / ".." / "page.pug", "include footer.pug\n", {{"a", "1"}}, ""));
+	EXPECT_FALSE(cache.find(key, {".html"}));
+	cache.store(key, {{".html", dir / "page.html"}}, {dir / "footer.pug"});
+
+	auto const entry = cache.find(key, {".html"});
+	ASSERT_TRUE(entry);
+	EXPECT_EQ("<p>Footer\n</p>\n"s, xxx::pug::impl::load_file(entry->files.front()));
+	EXPECT_EQ(1u, entry->dependencies.size());
+	EXPECT_FALSE(cache.find(key, {".html", ".html.gz"}));
+
+	std::ofstream{dir / "footer.pug"} << "p Modified\n";
+	EXPECT_FALSE(cache.find(key, {".html"}));
+	EXPECT_EQ(1u, cache.hits());
+	EXPECT_EQ(3u, cache.misses());
+	std::filesystem::remove_all(dir);
+}
+
+TEST(registry, Reload) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-registry";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	std::ofstream{dir / "page.pug"} << "p Old\n";
+
+	xxx::pug::registry::registry_t			   registry{dir};
+	xxx::pug::registry::registry_t::reader_t reader{registry};
+	auto const								   old = registry.find("page.pug");
+	EXPECT_EQ("<p>Old\n</p>\n"s, reader.render("page.pug"));
+	EXPECT_EQ(1u, registry.count());
+	EXPECT_EQ(0u, registry.reload());
+
+	std::ofstream{dir / "page.pug"} << "p New\n";
+	std::filesystem::last_write_time(dir / "page.pug", std::filesystem::last_write_time(dir / "page.pug") + std::chrono::seconds{1});
+	EXPECT_EQ(1u, registry.reload());
+	EXPECT_EQ("<p>Old\n</p>\n"s, old->render());
+	EXPECT_EQ("<p>New\n</p>\n"s, registry.find("page.pug")->render());
+	EXPECT_EQ("<p>New\n</p>\n"s, reader.render("page.pug"));
+	EXPECT_THROW(reader.get("missing.pug"), xxx::pug::ex::io_error);
+	std::filesystem::remove_all(dir);
+}
+TEST(registry, Outside) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-registry-outside";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir / "base" / "sub");
+	std::ofstream{dir / "secret.pug"} << "p Secret\n";
+	std::ofstream{dir / "base" / "page.pug"} << "p Page\n";
+
+	// Names are resolved only in the base directory.
+	xxx::pug::registry::registry_t			   registry{dir / "base"};
+	xxx::pug::registry::registry_t::reader_t reader{registry};
+	EXPECT_EQ("<p>Page\n</p>\n"s, reader.render("sub/../page.pug"));
+	EXPECT_THROW(reader.get("../secret.pug"), xxx::pug::ex::io_error);
+	EXPECT_THROW(reader.get("sub/../../secret.pug"), xxx::pug::ex::io_error);
+	EXPECT_THROW(registry.find((dir / "secret.pug").string()), xxx::pug::ex::io_error);
+	EXPECT_THROW(registry.find(""), xxx::pug::ex::io_error);
+	EXPECT_EQ(1u, registry.count());
+	std::filesystem::remove_all(dir);
+}
+TEST(registry, Budget) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-registry-budget";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	for (auto const* name: {"a.pug", "b.pug", "c.pug", "d.pug"}) std::ofstream{dir / name} << "p " << name << "\n";
+	xxx::pug::registry::registry_t measured{dir};
+	(void)measured.find("a.pug");
+
+	xxx::pug::registry::registry_t			   registry{dir, measured.size() * 3u};
+	xxx::pug::registry::registry_t::reader_t reader{registry};
+	for (auto const* name: {"a.pug", "b.pug", "c.pug", "a.pug"}) EXPECT_EQ("<p>"s + name + "\n</p>\n", reader.render(name));
+	EXPECT_EQ(3u, registry.count());
+	EXPECT_EQ("<p>d.pug\n</p>\n"s, reader.render("d.pug"));
+	EXPECT_EQ(3u, registry.count());
+	EXPECT_EQ(measured.size() * 3u, registry.size());
+
+	auto const version = registry.version();
+	(void)registry.find("a.pug");
+	(void)registry.find("c.pug");
+	EXPECT_EQ(version, registry.version());
+	(void)registry.find("b.pug");	 // The least recently used one was evicted.
+	EXPECT_EQ(version + 1u, registry.version());
+	std::filesystem::remove_all(dir);
+}
+TEST(registry, Share) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-registry-share";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	std::string const nav{"nav\n\tul\n\t\tli\n\t\t\ta(href='/') Home\n\t\tli\n\t\t\ta(href='/about') About\n\tif user == 'guest'\n\t\ta(href='/login') Log in\n\telse\n\t\tspan #{user}\n"};
+	std::ofstream{dir / "a.pug"} << nav << "p A\n";
+	std::ofstream{dir / "b.pug"} << nav << "p B\n";
+
+	xxx::pug::registry::registry_t private_{dir};
+	xxx::pug::registry::registry_t shared{dir, std::numeric_limits<std::size_t>::max(), true};
+	for (auto const* name: {"a.pug", "b.pug"}) {
+		for (auto const* user: {"guest", "mura"}) {
+			EXPECT_EQ(private_.find(name)->render({{"user", user}}), shared.find(name)->render({{"user", user}}));
+		}
+	}
+	EXPECT_EQ(0u, private_.shared());
+	EXPECT_LT(0u, shared.shared());
+	EXPECT_LT(shared.size(), private_.size());
+
+	auto const kept = shared.find("a.pug");
+	shared.erase("a.pug");
+	shared.erase("b.pug");
+	EXPECT_LT(0u, shared.shared());	   // The template kept refers them.
+	EXPECT_EQ(private_.find("a.pug")->render({{"user", "mura"}}), kept->render({{"user", "mura"}}));
+	std::filesystem::remove_all(dir);
+}
+
+TEST(loader, Memory) {
+	xxx::pug::memory_loader_t loader;
+	loader.add("views/layout.pug", "html\n\tblock content\n\tinclude parts/footer.pug\n");
+	loader.add("views/parts/footer.pug", "p #{name}\n");
+	loader.add("views/page.pug", "block content\n\tp Page\nextends ./layout.pug\n");
+	EXPECT_TRUE(loader.contains("./views/parts/../page.pug"));
+	EXPECT_FALSE(loader.contains("page.pug"));
+
+	xxx::pug::options_t options;
+	options.compact					= true;
+	options.loader					= &loader;
+	auto const				 compiled = xxx::pug::compile_file("views/page.pug", loader);
+	xxx::pug::variables_t const variables{{"name", "Footer"}};
+	auto const				 html = "<html><p>Page</p><p>Footer</p></html>"s;
+	EXPECT_EQ(html, compiled.render(variables, options));
+	EXPECT_EQ(html, compiled.render_segments(variables, options).str());
+	std::string chunks;
+	for (auto const& chunk: xxx::pug::render_chunks(compiled, variables, options, 1u)) chunks += chunk;
+	EXPECT_EQ(html, chunks);
+
+	EXPECT_THROW(xxx::pug::compile_file("views/missing.pug", loader), xxx::pug::ex::io_error);
+	EXPECT_THROW(xxx::pug::template_t("include missing.pug\n", "views/page.pug").render({}, options), xxx::pug::ex::io_error);
+	EXPECT_THROW(compiled.render(variables), xxx::pug::ex::io_error);	 // It is not on the filesystem.
+}
+
+TEST(render_session, Patch) {
+	xxx::pug::template_t const compiled{"div\n\th1 #{title}\n\t- var total = #{a}\n\tul\n\t\tli #{a}\n\t\tli #{b}\n\tif total == 1\n\t\tp one\n\telse\n\t\tp #{total}\n"};
+	xxx::pug::options_t options;
+	options.compact = true;
+	xxx::pug::variables_t		variables{{"title", "T"}, {"a", "1"}, {"b", "2"}};
+	xxx::pug::session_t			session{compiled, variables, options};
+	auto						html = session.html();
+	EXPECT_EQ("<div><h1>T</h1><ul><li>1</li><li>2</li></ul><p>1</p></div>"s, html);
+
+	auto const patches = session.update({{"b", "5"}});
+	EXPECT_EQ((std::vector<xxx::pug::patch_t>{{33u, 1u, "5"}}), patches);
+	EXPECT_TRUE(session.update({{"b", "5"}}).empty());
+	xxx::pug::apply_patches(html, patches);
+	xxx::pug::apply_patches(html, session.update({{"a", "2"}}));	// The variable 'total' refers it.
+	EXPECT_EQ("<div><h1>T</h1><ul><li>2</li><li>5</li></ul><p>2</p></div>"s, html);
+	EXPECT_EQ(html, session.html());
+	EXPECT_EQ(html, compiled.render({{"title", "T"}, {"a", "2"}, {"b", "5"}}, options));
+}
+
+TEST(parse_document, Edit) {
+	xxx::pug::options_t options;
+	options.compact = true;
+	xxx::pug::variables_t const variables{{"v", "2"}};
+	xxx::pug::document_t		doc{"div\n\tif v == 1\n\t\tp one\n\tp end\nul\n\tli a\n"};
+	auto const					expect = [&](std::string const& html) {
+		 EXPECT_EQ(html, doc.render(variables, options));
+		 EXPECT_EQ(xxx::pug::pug_string_with_variables(variables, doc.source(), "./", options), doc.render(variables, options));
+	};
+	expect("<div><p>end</p></div><ul><li>a</li></ul>"s);
+
+	doc.edit(3u, 0u, "\telse if v == 2\n\t\tp two\n");	  // Links the inserted branch.
+	expect("<div><p>two</p><p>end</p></div><ul><li>a</li></ul>"s);
+	EXPECT_TRUE(doc.root()->children()[0]->children()[1]->chained());
+	doc.edit(3u, 1u, "\tp");	// The lines following it are appended to another node.
+	expect("<div><p><p>two</p></p><p>end</p></div><ul><li>a</li></ul>"s);
+	EXPECT_FALSE(doc.root()->children()[0]->children()[1]->chained());
+	doc.edit(7u, 1u, std::string_view{});
+	doc.edit(7u, 0u, "\tli b");
+	expect("<div><p><p>two</p></p><p>end</p></div><ul><li>b</li></ul>"s);
+
+	auto const source = doc.source();
+	EXPECT_THROW(doc.edit(0u, 1u, "| folding"), xxx::pug::ex::syntax_error);
+	EXPECT_THROW(doc.edit(doc.lines(), 1u, "p"), std::out_of_range);
+	EXPECT_EQ(source, doc.source());
+	expect("<div><p><p>two</p></p><p>end</p></div><ul><li>b</li></ul>"s);
+}
+
+TEST(parse_document, Independent) {
+	xxx::pug::document_t doc{"ul\n\t- for (var i = 0; i < 100; i += 1)\n\t\tli\n\t\t\tp #{i}\n"};
+	auto const			 loop = [&doc] { return doc.root()->children()[0]->children()[0]; };
+	EXPECT_TRUE(loop()->independent());
+	doc.edit(4u, 0u, "\t\t\t- var n = b");	// The enclosing loop is marked again.
+	EXPECT_FALSE(loop()->independent());
+	doc.edit(4u, 1u, std::string_view{});
+	EXPECT_TRUE(loop()->independent());
+}
+
+TEST(render_if, Chain) {
+	std::string const pug{"if v == 1\n\tp one\nelse if v == 2\n\tp two\nelse\n\tp other\nif v == 2\n\tp again\np end\n"};
+	for (auto const& [v, html]: {std::pair{"1", "\t<p>one\n\t</p>\n<p>end\n</p>\n"}, std::pair{"2", "\t<p>two\n\t</p>\n\t<p>again\n\t</p>\n<p>end\n</p>\n"}, std::pair{"3", "\t<p>other\n\t</p>\n<p>end\n</p>\n"}}) {
+		EXPECT_EQ(std::string{html}, xxx::pug::pug_string_with_variables({{"v", v}}, pug));
+	}
+	auto const root = xxx::pug::impl::parse_file(pug);
+	EXPECT_EQ(2u, root->children()[0]->branches().size());
+	EXPECT_TRUE(root->children()[1]->chained());
+	EXPECT_TRUE(root->children()[3]->branches().empty());
+
+	std::string const malformed{"if v == 1\n\tp one\nelse\n\tp other\nelse\n\tp another\n"};
+	EXPECT_EQ("\t<p>one\n\t</p>\n"s, xxx::pug::pug_string_with_variables({{"v", "1"}}, malformed));
+	EXPECT_THROW(xxx::pug::pug_string_with_variables({{"v", "2"}}, malformed), xxx::pug::ex::syntax_error);
+}
+
+TEST(render_case, Table) {
+	std::string const pug{"case v\n\twhen \"a\"\n\twhen \"b\"\n\t\tp ab\n\twhen \"c\"\n\t\t- break\n\tdefault\n\t\tp other\n"};
+	for (auto const& [v, html]: {std::pair{"a", "\t\t<p>ab\n\t\t</p>\n"}, std::pair{"b", "\t\t<p>ab\n\t\t</p>\n"}, std::pair{"c", ""}, std::pair{"d", "\t\t<p>other\n\t\t</p>\n"}}) {
+		EXPECT_EQ(std::string{html}, xxx::pug::pug_string_with_variables({{"v", v}}, pug));
+	}
+	auto const root = xxx::pug::impl::parse_file(pug);
+	ASSERT_TRUE(root->children()[0]->cases());
+	EXPECT_EQ(4u, root->children()[0]->cases()->size());
+
+	EXPECT_THROW(xxx::pug::pug_string_with_variables({{"v", "a"}}, "case v\n\twhen \"a\"\n\t\tp a\n\twhen \"a\"\n\t\tp b\n"), xxx::pug::ex::syntax_error);
+}
+
+TEST(render_deep, Depth) {
+	auto const build = [](std::size_t depth) {
+		auto const root = std::make_shared<xxx::pug::impl::line_node_t>(xxx::pug::impl::line_t{0u, std::string_view{}}, nullptr);
+		for (auto node = root; node->nest() < depth;) {
+			node = node->push_nest({node->nest() + 1u, "b"}, node);
+		}
+		xxx::pug::impl::link_conditionals(*root);
+		return root;
+	};
+	auto const html = [](std::size_t depth) {
+		std::string html;
+		for (std::size_t i = 0u; i < depth; ++i) html += "<b>";
+		for (std::size_t i = 0u; i < depth; ++i) html += "</b>";
+		return html;
+	};
+	xxx::pug::options_t options;
+	options.compact = true;
+	EXPECT_EQ(html(100000u), std::get<0>(xxx::pug::impl::parse_line(xxx::pug::impl::context_t{{}, options}, build(100000u), "./")));
+
+	auto const root = build(10000u);
+	(void)xxx::pug::impl::compile_fragments(*root, xxx::pug::impl::last_fragment);
+	xxx::pug::impl::context_t context{{}, options};
+	xxx::pug::segments_t	  segments;
+	xxx::pug::impl::render_segments(context, root, "./", segments);
+	EXPECT_EQ(html(10000u), segments.str());
+	std::string buffer, chunks;
+	for (auto&& chunk: xxx::pug::impl::render_chunks(context, root, "./", buffer, 4096u)) {
+		chunks += chunk;
+	}
+	EXPECT_EQ(html(10000u), chunks + buffer);
+
+	std::string pug;
+	for (std::size_t i = 0u; i < 3000u; ++i) pug += std::string(i, '\t') + "b\n";
+	EXPECT_EQ(html(3000u), xxx::pug::pug_string(pug, "./", options));
+	EXPECT_TRUE(xxx::pug::check_string(pug).empty());
+}
+
+TEST(render_resource, Monotonic) {
+	// It counts allocations to the upstream resource.
+	class counting_t : public std::pmr::memory_resource {
+	public:
+		std::size_t count{};
+
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+			++count;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+		void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override { std::pmr::new_delete_resource()->deallocate(p, bytes, alignment); }
+		bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+	};
+	std::string const			pug{"html\n\tbody\n\t\t- var b = 'Def'\n\t\teach i in [1, 2, 3]\n\t\t\tp #{a} #{b} #{i}\n"};
+	xxx::pug::variables_t const variables{{"a", "Abc"}};
+
+	counting_t					 compiling;
+	xxx::pug::template_t const	 compiled{pug, "./", &compiling};
+	EXPECT_LT(0u, compiling.count);
+
+	counting_t							rendering;
+	std::pmr::monotonic_buffer_resource arena{&rendering};
+	xxx::pug::options_t					options;
+	options.resource = &arena;
+	EXPECT_EQ(compiled.render(variables), compiled.render(variables, options));
+	EXPECT_EQ(xxx::pug::pug_string_with_variables(variables, pug), xxx::pug::pug_string_with_variables(variables, pug, "./", options));
+	EXPECT_LT(0u, rendering.count);
+}
+
+TEST(render_chunks, Concatenated) {
+	std::string const			 pug{"doctype html\nhtml\n\thead\n\t\ttitle #{a}\n\tbody\n\t\teach i in [1, 2, 3]\n\t\t\tp #{i}\n"};
+	xxx::pug::template_t const	 compiled{pug};
+	xxx::pug::variables_t const	 variables{{"a", "Abc"}};
+	for (std::size_t const size: {1u, 16u, 1024u}) {
+		std::vector<std::string> chunks;
+		for (auto&& chunk: xxx::pug::render_chunks(compiled, variables, {}, size)) {
+			EXPECT_FALSE(chunk.empty());
+			chunks.push_back(std::move(chunk));
+		}
+		EXPECT_EQ(compiled.render(variables), std::accumulate(chunks.cbegin(), chunks.cend(), std::string{}));
+		EXPECT_EQ(size < 1024u ? "<!DOCTYPE html>\n"s : compiled.render(variables), chunks.front());
+	}
+}
+TEST(render_chunks, Error) {
+	xxx::pug::template_t const compiled{"p Abc\nif a == 1\n\tp\n"};
+	auto					   chunks = xxx::pug::render_chunks(compiled, {}, {}, 1u);
+	auto					   itr	  = chunks.begin();
+	EXPECT_EQ("<p>Abc\n"s, *itr);
+	EXPECT_EQ("</p>\n"s, *++itr);
+	EXPECT_THROW(++itr, xxx::pug::ex::syntax_error);
+}
+TEST(render_segments, Concatenated) {
+	std::string const text(100u, 'x');
+	std::string const pug{"doctype html\nhtml\n\tbody\n\t\tp " + text + "\n\t\tp\n\t\t\t| " + text + "\n\t\tp #{a} " + text + "\n\t\tscript\n\t\t\t.\n\t\t\t\t" + text + "\n\t\teach i in [1, 2]\n\t\t\tp #{i}\n"};
+	xxx::pug::template_t const	compiled{pug};
+	xxx::pug::variables_t const variables{{"a", "Abc"}};
+	for (bool const compact: {false, true}) {
+		xxx::pug::options_t options;
+		options.compact		= compact;
+		auto const segments = compiled.render_segments(variables, options);
+		auto const html		= compiled.render(variables, options);
+		EXPECT_EQ(html, segments.str());
+		EXPECT_EQ(html.size(), segments.size());
+		EXPECT_LE(segments.copied() + 4u * text.size(), segments.size());	 // Text of the source is referred without copying.
+
+		std::string buffer(html.size() / 2u, '\0');
+		EXPECT_EQ(buffer.size(), segments.copy_to(buffer.data(), buffer.size()));
+		EXPECT_EQ(html.substr(0u, buffer.size()), buffer);
+	}
+}
+
+TEST(json_parse_object, Flat) {
+	auto const doc = xxx::pug::json::parse_object(R"( {"a": "x\"y\u00e9", "b": -12.5e3, "c": true, "d": null, "e": "" } )");
+	EXPECT_EQ(3u + 1u, doc.variables.size());
+	EXPECT_EQ("x\"y\xc3\xa9"s, doc.variables.at("a"));
+	EXPECT_EQ("-12.5e3"s, doc.variables.at("b"));
+	EXPECT_EQ("true"s, doc.variables.at("c"));
+	EXPECT_FALSE(doc.variables.contains("d"));
+	EXPECT_EQ(""s, doc.variables.at("e"));
+	EXPECT_TRUE(xxx::pug::json::parse_object("").variables.empty());
+	EXPECT_TRUE(xxx::pug::json::parse_object("{}").variables.empty());
+}
+TEST(json_parse_object, Invalid) {
+	EXPECT_THROW(xxx::pug::json::parse_object(R"({"a": [1]})"), xxx::pug::ex::syntax_error);
+	EXPECT_THROW(xxx::pug::json::parse_object(R"({"a": "x)"), xxx::pug::ex::syntax_error);
+	EXPECT_THROW(xxx::pug::json::parse_object(R"({"a" 1})"), xxx::pug::ex::syntax_error);
+	EXPECT_THROW(xxx::pug::json::parse_object(R"({"a": 1} x)"), xxx::pug::ex::syntax_error);
+}
+
+#if __has_include(<sys/un.h>)
+TEST(serve, Respond) {
+	auto const dir = std::filesystem::temp_directory_path() / "pug-ut-serve";
+	std::filesystem::create_directories(dir);
+	auto const page = dir / "page.pug";
+	std::ofstream{page} << "p #{a}\n";
+	xxx::pug::serve::cache_t	cache;
+	xxx::pug::options_t const	options{.compact = true};
+	auto const					request = page.string() + "\n{\"a\": \"1\"}";
+	EXPECT_EQ("OK\n<p>1</p>"s, xxx::pug::serve::respond(cache, request, options).str());
+
+	// It is compiled again when the file is modified.
+	auto const time = std::filesystem::last_write_time(page);
+	std::ofstream{page} << "div #{a}\n";
+	std::filesystem::last_write_time(page, time + std::chrono::seconds{1});
+	EXPECT_EQ("OK\n<div>1</div>"s, xxx::pug::serve::respond(cache, request, options).str());
+
+	EXPECT_TRUE(xxx::pug::serve::respond(cache, (dir / "missing.pug").string(), options).str().starts_with("ERROR "));
+	EXPECT_TRUE(xxx::pug::serve::respond(cache, page.string() + "\n{\"a\": ", options).str().starts_with("ERROR "));
+	std::filesystem::remove_all(dir);
+}
+TEST(serve, Read) {
+	int fds[2]{};
+	ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+	xxx::pug::serve::impl::fd_t const reader{fds[0]}, writer{fds[1]};
+	xxx::pug::serve::impl::set_receive_timeout(reader.get(), std::chrono::milliseconds{10});
+	xxx::pug::serve::impl::write_all(writer.get(), "12345");
+	EXPECT_THROW(xxx::pug::serve::impl::read_all(reader.get(), 4u), xxx::pug::ex::io_error);	 // Too long.
+	EXPECT_THROW(xxx::pug::serve::impl::read_all(reader.get()), xxx::pug::ex::io_error);		 // The writer never shuts down.
+
+	xxx::pug::serve::impl::write_all(writer.get(), "12345");
+	::shutdown(writer.get(), SHUT_WR);
+	EXPECT_EQ("12345"s, xxx::pug::serve::impl::read_all(reader.get(), 5u));
+}
+#endif
+
+TEST(libpug, Render) {
+	pug_engine* const engine = pug_engine_create();
+	ASSERT_NE(nullptr, engine);
+	std::string const pug{"p #{a}\n"};
+	pug_template*	  compiled{};
+	EXPECT_EQ(PUG_OK, pug_template_compile_string(engine, pug.data(), pug.size(), nullptr, &compiled));
+	EXPECT_EQ(PUG_OK, pug_engine_set_variable(engine, "a", "Abc"));
+	EXPECT_EQ(PUG_OK, pug_engine_set_compact(engine, 1));
+
+	std::size_t size{};
+	EXPECT_EQ(PUG_ERROR_BUFFER_TOO_SMALL, pug_render(engine, compiled, nullptr, &size));
+	EXPECT_EQ(10u, size);
+	std::string html(size, '\0');
+	EXPECT_EQ(PUG_OK, pug_render(engine, compiled, html.data(), &size));
+	EXPECT_EQ("<p>Abc</p>"s, html);
+
+	pug_template_destroy(compiled);
+	pug_engine_destroy(engine);
+}
+TEST(libpug, Error) {
+	pug_engine* const engine = pug_engine_create();
+	ASSERT_NE(nullptr, engine);
+	std::string const pug{"if a == 1\n\tp\n"};
+	pug_template*	  compiled{};
+	EXPECT_EQ(PUG_OK, pug_template_compile_string(engine, pug.data(), pug.size(), nullptr, &compiled));
+	std::size_t size{};
+	EXPECT_EQ(PUG_ERROR_SYNTAX, pug_render(engine, compiled, nullptr, &size));
+	EXPECT_EQ(PUG_ERROR_SYNTAX, pug_engine_last_error(engine));
+	EXPECT_EQ(PUG_ERROR_IO, pug_template_compile_file(engine, "/nonexistent.pug", &compiled));
+	EXPECT_EQ(PUG_ERROR_INVALID_ARGUMENT, pug_engine_set_variable(engine, "", "x"));
+	EXPECT_EQ(PUG_ERROR_INVALID_ARGUMENT, pug_render(nullptr, compiled, nullptr, &size));
+
+	pug_template_destroy(compiled);
+	pug_engine_destroy(engine);
+}
+
+///	@}